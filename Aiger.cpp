@@ -0,0 +1,447 @@
+#include "Aiger.h"
+#include "utils.h"
+
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <tr1/unordered_set>
+
+using std::string;
+using std::vector;
+using std::pair;
+using std::stringstream;
+using std::tr1::unordered_set;
+using boost::string_ref;
+
+AigerReader::AigerReader(const string& filename) : file(filename), pos(0)
+{
+}
+
+unsigned int AigerReader::read_number()
+{
+    if ((pos == file.end()) || (*pos < '0') || (*pos > '9')) {
+        throw Error("Invalid AIGER file");
+    }
+    unsigned long long value = 0;
+    while ((pos != file.end()) && (*pos >= '0') && (*pos <= '9')) {
+        value = value * 10 + (*pos++ - '0');
+        if (value > 0xffffffffULL) {
+            throw Error("Invalid AIGER file");
+        }
+    }
+    return value;
+}
+
+unsigned int AigerReader::read_delta()
+{
+    unsigned int value = 0;
+    for (int shift = 0; ; shift += 7) {
+        if ((pos == file.end()) || (shift > 28)) {
+            throw Error("Invalid AIGER file");
+        }
+        unsigned char byte = *pos++;
+        value |= (unsigned int)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+void AigerReader::expect(char chr)
+{
+    if ((pos == file.end()) || (*pos != chr)) {
+        throw Error("Invalid AIGER file");
+    }
+    ++pos;
+}
+
+const string& AigerReader::lit_name(unsigned int lit)
+{
+    unsigned int var = lit >> 1;
+    if (var == 0) {
+        throw Error("Found a constant");
+    }
+    if ((var >= var_names.size()) || var_names[var].empty()) {
+        throw Error("Invalid AIGER file");
+    }
+    return var_names[var];
+}
+
+void AigerReader::add_names(const vector<unsigned int>& lits, const string& output)
+{
+    BlifStatement statement;
+    statement.kind = BlifStatement::NAMES;
+    statement.no_table = false;
+    statement.table_missing = false;
+
+    pair<int, string> table(lits.size(), string());
+    for (int i = 0; i < int(lits.size()); ++i) {
+        const string& name = lit_name(lits[i]);
+        statement.names.push_back(string_ref(name));
+        table.second += (lits[i] & 1) ? '0' : '1';
+    }
+    statement.names.push_back(string_ref(output));
+    table.second += " 1\n";
+
+    statement.table = std::find(tables.begin(), tables.end(), table) - tables.begin();
+    if (statement.table == int(tables.size())) {
+        tables.push_back(table);
+    }
+    statements.push_back(statement);
+}
+
+void AigerReader::read()
+{
+    pos = file.begin();
+    bool binary;
+    if ((file.end() - pos >= 4) && (memcmp(pos, "aig ", 4) == 0)) {
+        binary = true;
+    } else if ((file.end() - pos >= 4) && (memcmp(pos, "aag ", 4) == 0)) {
+        binary = false;
+    } else {
+        throw Error("Invalid AIGER file");
+    }
+    pos += 4;
+
+    // M I L O A, then the bad state, constraint, justice and
+    // fairness counts of AIGER 1.9
+    unsigned int max_var = read_number();
+    expect(' ');
+    unsigned int num_inputs = read_number();
+    expect(' ');
+    unsigned int num_latches = read_number();
+    expect(' ');
+    unsigned int num_outputs = read_number();
+    expect(' ');
+    unsigned int num_ands = read_number();
+    while ((pos != file.end()) && (*pos == ' ')) {
+        ++pos;
+        if (read_number() != 0) {
+            throw Error("AIGER properties are not supported");
+        }
+    }
+    expect('\n');
+    if ((unsigned long long)(num_inputs) + num_latches + num_ands > max_var) {
+        throw Error("Invalid AIGER file");
+    }
+    unsigned int max_lit = 2 * max_var + 1;
+
+    vector<unsigned int> input_lits(num_inputs);
+    for (unsigned int i = 0; i < num_inputs; ++i) {
+        if (binary) {
+            input_lits[i] = 2 * (i + 1);
+        } else {
+            input_lits[i] = read_number();
+            expect('\n');
+        }
+    }
+
+    vector<unsigned int> latch_lits(num_latches);
+    vector<unsigned int> latch_next(num_latches);
+    for (unsigned int i = 0; i < num_latches; ++i) {
+        if (binary) {
+            latch_lits[i] = 2 * (num_inputs + i + 1);
+        } else {
+            latch_lits[i] = read_number();
+            expect(' ');
+        }
+        latch_next[i] = read_number();
+
+        // initial value (ignored like the .latch init value)
+        if ((pos != file.end()) && (*pos == ' ')) {
+            ++pos;
+            read_number();
+        }
+        expect('\n');
+    }
+
+    vector<unsigned int> output_lits(num_outputs);
+    for (unsigned int i = 0; i < num_outputs; ++i) {
+        output_lits[i] = read_number();
+        expect('\n');
+    }
+
+    // lhs, rhs0, rhs1 of each AND node
+    vector<unsigned int> ands(3 * num_ands);
+    for (unsigned int i = 0; i < num_ands; ++i) {
+        unsigned int* node = &ands[3 * i];
+        if (binary) {
+            node[0] = 2 * (num_inputs + num_latches + i + 1);
+            unsigned int delta = read_delta();
+            if (delta > node[0]) {
+                throw Error("Invalid AIGER file");
+            }
+            node[1] = node[0] - delta;
+            delta = read_delta();
+            if (delta > node[1]) {
+                throw Error("Invalid AIGER file");
+            }
+            node[2] = node[1] - delta;
+        } else {
+            node[0] = read_number();
+            expect(' ');
+            node[1] = read_number();
+            expect(' ');
+            node[2] = read_number();
+            expect('\n');
+        }
+    }
+
+    // symbol table (the comment section is ignored)
+    vector<string> input_names(num_inputs);
+    vector<string> latch_names(num_latches);
+    vector<string> output_names(num_outputs);
+    while ((pos != file.end()) && (*pos != 'c')) {
+        char type = *pos++;
+        unsigned int index = read_number();
+        expect(' ');
+        const char* eol = (const char*)(memchr(pos, '\n', file.end() - pos));
+        if (!eol) {
+            eol = file.end();
+        }
+        string name(pos, eol);
+        pos = (eol == file.end()) ? eol : eol + 1;
+        if ((type == 'i') && (index < num_inputs)) {
+            input_names[index] = name;
+        } else if ((type == 'l') && (index < num_latches)) {
+            latch_names[index] = name;
+        } else if ((type == 'o') && (index < num_outputs)) {
+            output_names[index] = name;
+        } else {
+            throw Error("Invalid AIGER symbol");
+        }
+    }
+
+    // name the wire of every variable
+    var_names.assign(max_var + 1, string());
+    unordered_set<string> used;
+    for (unsigned int i = 0; i < num_inputs; ++i) {
+        if (input_names[i].empty()) {
+            stringstream name;
+            name << "i" << i;
+            input_names[i] = name.str();
+        }
+        if ((input_lits[i] & 1) || (input_lits[i] < 2) || (input_lits[i] > max_lit)) {
+            throw Error("Invalid AIGER file");
+        }
+        var_names[input_lits[i] >> 1] = input_names[i];
+        used.insert(input_names[i]);
+    }
+    for (unsigned int i = 0; i < num_latches; ++i) {
+        if (latch_names[i].empty()) {
+            stringstream name;
+            name << "l" << i;
+            latch_names[i] = name.str();
+        }
+        if ((latch_lits[i] & 1) || (latch_lits[i] < 2) || (latch_lits[i] > max_lit) ||
+                (latch_next[i] > max_lit)) {
+            throw Error("Invalid AIGER file");
+        }
+        var_names[latch_lits[i] >> 1] = latch_names[i];
+        used.insert(latch_names[i]);
+    }
+    for (unsigned int i = 0; i < num_outputs; ++i) {
+        if (output_names[i].empty()) {
+            stringstream name;
+            name << "o" << i;
+            output_names[i] = name.str();
+        }
+        if (output_lits[i] > max_lit) {
+            throw Error("Invalid AIGER file");
+        }
+        used.insert(output_names[i]);
+    }
+
+    vector<bool> is_and(max_var + 1, false);
+    for (unsigned int i = 0; i < num_ands; ++i) {
+        const unsigned int* node = &ands[3 * i];
+        if ((node[0] & 1) || (node[0] < 2) || (node[0] > max_lit) ||
+                (node[1] > max_lit) || (node[2] > max_lit) ||
+                !var_names[node[0] >> 1].empty() || is_and[node[0] >> 1]) {
+            throw Error("Invalid AIGER file");
+        }
+        is_and[node[0] >> 1] = true;
+    }
+
+    // an AND node driving an output directly takes the output name
+    vector<bool> direct(num_outputs, false);
+    for (unsigned int i = 0; i < num_outputs; ++i) {
+        unsigned int var = output_lits[i] >> 1;
+        if (output_lits[i] & 1) {
+            continue;
+        }
+        if (is_and[var] && var_names[var].empty()) {
+            var_names[var] = output_names[i];
+        }
+        direct[i] = (var_names[var] == output_names[i]);
+    }
+    for (unsigned int var = 1; var <= max_var; ++var) {
+        if (is_and[var] && var_names[var].empty()) {
+            stringstream name;
+            name << "n" << var;
+            string wire_name = name.str();
+            while (used.count(wire_name)) {
+                wire_name += '_';
+            }
+            var_names[var] = wire_name;
+            used.insert(wire_name);
+        }
+    }
+
+    names.clear();
+    statements.clear();
+    tables.clear();
+
+    BlifStatement ports;
+    ports.no_table = false;
+    ports.table = -1;
+    ports.table_missing = false;
+    ports.kind = BlifStatement::INPUTS;
+    for (unsigned int i = 0; i < num_inputs; ++i) {
+        ports.names.push_back(string_ref(var_names[input_lits[i] >> 1]));
+    }
+    statements.push_back(ports);
+    ports.kind = BlifStatement::OUTPUTS;
+    ports.names.clear();
+    for (unsigned int i = 0; i < num_outputs; ++i) {
+        names.push_back(output_names[i]);
+        ports.names.push_back(string_ref(names.back()));
+    }
+    statements.push_back(ports);
+
+    // a latch reads an AND node or a port directly, or an inverter
+    // (latch and name of its inverter output)
+    vector<pair<unsigned int, int> > inverted_latches;
+    for (unsigned int i = 0; i < num_latches; ++i) {
+        BlifStatement latch = ports;
+        latch.kind = BlifStatement::LATCH;
+        latch.names.clear();
+        if (latch_next[i] & 1) {
+            string input = latch_names[i] + "_in";
+            while (used.count(input)) {
+                input += '_';
+            }
+            used.insert(input);
+            inverted_latches.push_back(std::make_pair(i, int(names.size())));
+            names.push_back(input);
+            latch.names.push_back(string_ref(names.back()));
+        } else {
+            latch.names.push_back(string_ref(lit_name(latch_next[i])));
+        }
+        latch.names.push_back(string_ref(var_names[latch_lits[i] >> 1]));
+        statements.push_back(latch);
+    }
+
+    vector<unsigned int> lits(2);
+    for (unsigned int i = 0; i < num_ands; ++i) {
+        lits[0] = ands[3 * i + 1];
+        lits[1] = ands[3 * i + 2];
+        add_names(lits, var_names[ands[3 * i] >> 1]);
+    }
+
+    lits.resize(1);
+    for (unsigned int i = 0; i < num_outputs; ++i) {
+        if (!direct[i]) {
+            lits[0] = output_lits[i];
+            add_names(lits, names[i]);
+        }
+    }
+    for (int i = 0; i < int(inverted_latches.size()); ++i) {
+        lits[0] = latch_next[inverted_latches[i].first];
+        add_names(lits, names[inverted_latches[i].second]);
+    }
+}
+
+unsigned int AigerWriter::add_input(const string& name)
+{
+    if (!ands.empty()) {
+        throw Error("AIGER inputs must be added before AND nodes");
+    }
+    input_names.push_back(name);
+    ++num_inputs;
+    return 2 * num_inputs;
+}
+
+unsigned int AigerWriter::add_and(unsigned int lit0, unsigned int lit1)
+{
+    if (lit0 < lit1) {
+        std::swap(lit0, lit1);
+    }
+    if ((lit1 == 0) || (lit0 == (lit1 ^ 1))) {
+        return 0;
+    }
+    if ((lit1 == 1) || (lit0 == lit1)) {
+        return lit0;
+    }
+
+    AndInputs inputs(lit0, lit1);
+    std::tr1::unordered_map<AndInputs, unsigned int, boost::hash<AndInputs> >::iterator iter =
+        and_lits.find(inputs);
+    if (iter != and_lits.end()) {
+        return iter->second;
+    }
+    ands.push_back(inputs);
+    unsigned int lit = 2 * (num_inputs + ands.size());
+    and_lits[inputs] = lit;
+    return lit;
+}
+
+void AigerWriter::add_output(unsigned int lit, const string& name)
+{
+    outputs.push_back(lit);
+    output_names.push_back(name);
+}
+
+void AigerWriter::add_comment(const string& line)
+{
+    comments.push_back(line);
+}
+
+// 7 bits per byte, lowest first; the high bit marks more bytes
+static void write_delta(string& out, unsigned int delta)
+{
+    while (delta & ~0x7fu) {
+        out += char((delta & 0x7f) | 0x80);
+        delta >>= 7;
+    }
+    out += char(delta);
+}
+
+void AigerWriter::write(const string& filename)
+{
+    stringstream text;
+    text << "aig " << num_inputs + ands.size() << " " << num_inputs << " 0 "
+        << outputs.size() << " " << ands.size() << "\n";
+    for (int i = 0; i < int(outputs.size()); ++i) {
+        text << outputs[i] << "\n";
+    }
+
+    string out = text.str();
+    for (int i = 0; i < int(ands.size()); ++i) {
+        unsigned int lhs = 2 * (num_inputs + i + 1);
+        write_delta(out, lhs - ands[i].first);
+        write_delta(out, ands[i].first - ands[i].second);
+    }
+
+    text.str("");
+    for (int i = 0; i < num_inputs; ++i) {
+        text << "i" << i << " " << input_names[i] << "\n";
+    }
+    for (int i = 0; i < int(outputs.size()); ++i) {
+        text << "o" << i << " " << output_names[i] << "\n";
+    }
+    if (!comments.empty()) {
+        text << "c\n";
+        for (int i = 0; i < int(comments.size()); ++i) {
+            text << comments[i] << "\n";
+        }
+    }
+    out += text.str();
+
+    std::ofstream fout(filename.c_str(), std::ios::binary);
+    fout.write(out.data(), out.size());
+    if (!fout) {
+        throw Error("Cannot write AIGER file");
+    }
+}
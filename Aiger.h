@@ -0,0 +1,126 @@
+#ifndef AIGER_H
+#define AIGER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <tr1/unordered_map>
+#include <boost/functional/hash.hpp>
+#include "MappedFile.h"
+#include "BlifReader.h"
+
+/*!
+ * Reads an AIGER file (binary "aig" or ASCII "aag") as the BLIF
+ * statements of the same netlist.  Every AND node becomes a 2-input
+ * .names whose table holds the complemented edges, named n<var> unless
+ * it drives an output of the same polarity (then it takes the output
+ * name).  Other outputs and latch inputs get a buffer or an inverter.
+ * Unnamed inputs, latches and outputs are named i<k>, l<k> and o<k>.
+*/
+class AigerReader {
+  public:
+    /*!
+     * Throws an Error if the file cannot be opened.
+    */
+    AigerReader(const std::string& filename);
+
+    /*!
+     * Read the file.  Throws an Error if it is not a valid AIGER file
+     * or uses constants or properties (bad states, constraints).
+    */
+    void read();
+
+    const std::vector<BlifStatement>& get_statements() const
+    {
+        return statements;
+    }
+
+    //! distinct (number of inputs, truth table) pairs of the statements
+    const std::vector<std::pair<int, std::string> >& get_tables() const
+    {
+        return tables;
+    }
+
+  private:
+    //! non-negative number at the current position
+    unsigned int read_number();
+
+    //! binary delta of an AND node
+    unsigned int read_delta();
+
+    //! skip the given character (throws an Error if not found)
+    void expect(char chr);
+
+    //! add a .names reading the wires of the literals
+    void add_names(const std::vector<unsigned int>& lits, const std::string& output);
+
+    //! name of the wire of a literal (throws an Error for constants)
+    const std::string& lit_name(unsigned int lit);
+
+    MappedFile file;
+    const char* pos;
+
+    //! wire name of each variable
+    std::vector<std::string> var_names;
+
+    //! strings referred to by the statements
+    std::deque<std::string> names;
+
+    std::vector<BlifStatement> statements;
+    std::vector<std::pair<int, std::string> > tables;
+};
+
+/*!
+ * Builds an and-inverter graph and writes it as a binary AIGER file.
+ * All inputs are added before the first AND node.  Equal AND nodes are
+ * shared and ANDs with constant or equal inputs are simplified.
+*/
+class AigerWriter {
+  public:
+    AigerWriter() : num_inputs(0) {}
+
+    //! literal of a new input
+    unsigned int add_input(const std::string& name);
+
+    unsigned int add_and(unsigned int lit0, unsigned int lit1);
+
+    unsigned int add_or(unsigned int lit0, unsigned int lit1)
+    {
+        return add_and(lit0 ^ 1, lit1 ^ 1) ^ 1;
+    }
+
+    unsigned int add_xor(unsigned int lit0, unsigned int lit1)
+    {
+        return add_or(add_and(lit0, lit1 ^ 1), add_and(lit0 ^ 1, lit1));
+    }
+
+    //! sel ? lit1 : lit0
+    unsigned int add_mux(unsigned int sel, unsigned int lit1, unsigned int lit0)
+    {
+        return add_or(add_and(sel, lit1), add_and(sel ^ 1, lit0));
+    }
+
+    void add_output(unsigned int lit, const std::string& name);
+
+    //! line of the comment section
+    void add_comment(const std::string& line);
+
+    /*!
+     * Throws an Error if the file cannot be written.
+    */
+    void write(const std::string& filename);
+
+  private:
+    typedef std::pair<unsigned int, unsigned int> AndInputs;
+
+    int num_inputs;
+    std::vector<std::string> input_names;
+    std::vector<unsigned int> outputs;
+    std::vector<std::string> output_names;
+    std::vector<AndInputs> ands;
+    std::tr1::unordered_map<AndInputs, unsigned int, boost::hash<AndInputs> > and_lits;
+    std::vector<std::string> comments;
+};
+
+#endif
@@ -0,0 +1,198 @@
+#include "BenchReader.h"
+#include "utils.h"
+
+#include <cstring>
+#include <cctype>
+#include <sstream>
+
+using std::string;
+using std::vector;
+using std::pair;
+using boost::string_ref;
+
+//! gates of a .bench file (DFF is handled as a latch)
+enum BenchGate { BENCH_AND, BENCH_NAND, BENCH_OR, BENCH_NOR, BENCH_XOR, BENCH_XNOR,
+    BENCH_NOT, BENCH_BUFF, NUM_BENCH_GATES };
+
+static const char* BENCH_GATE_NAMES[NUM_BENCH_GATES] = {
+    "AND", "NAND", "OR", "NOR", "XOR", "XNOR", "NOT", "BUFF"
+};
+
+//! widest XOR/XNOR (the table lists every minterm)
+const int MAX_BENCH_XOR_INPUTS = 16;
+
+static string_ref trim(string_ref str)
+{
+    while (!str.empty() && isspace((unsigned char)(str.front()))) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && isspace((unsigned char)(str.back()))) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+static bool equal_nocase(string_ref str, const char* keyword)
+{
+    std::size_t size = strlen(keyword);
+    if (str.size() != size) {
+        return false;
+    }
+    for (std::size_t i = 0; i < size; ++i) {
+        if (toupper((unsigned char)(str[i])) != keyword[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void bad_line(int line)
+{
+    std::stringstream msg;
+    msg << "Invalid .bench line " << line;
+    throw Error(msg.str());
+}
+
+BenchReader::BenchReader(const string& filename) : file(filename)
+{
+}
+
+int BenchReader::gate_table(string_ref type, int num_inputs, int line)
+{
+    int gate = 0;
+    while ((gate < NUM_BENCH_GATES) && !equal_nocase(type, BENCH_GATE_NAMES[gate])) {
+        ++gate;
+    }
+    if (equal_nocase(type, "BUF")) {
+        gate = BENCH_BUFF;
+    }
+    if (gate == NUM_BENCH_GATES) {
+        throw Error("Unknown .bench gate " + type.to_string());
+    }
+    if ((num_inputs == 0) || (((gate == BENCH_NOT) || (gate == BENCH_BUFF)) && (num_inputs != 1)) ||
+            (((gate == BENCH_XOR) || (gate == BENCH_XNOR)) && (num_inputs > MAX_BENCH_XOR_INPUTS))) {
+        bad_line(line);
+    }
+
+    pair<int, int> key(gate, num_inputs);
+    std::map<pair<int, int>, int>::iterator iter = gate_tables.find(key);
+    if (iter != gate_tables.end()) {
+        return iter->second;
+    }
+
+    string table;
+    switch (gate) {
+        case BENCH_AND: table = string(num_inputs, '1') + " 1\n"; break;
+        case BENCH_NAND: table = string(num_inputs, '1') + " 0\n"; break;
+        case BENCH_OR: table = string(num_inputs, '0') + " 0\n"; break;
+        case BENCH_NOR: table = string(num_inputs, '0') + " 1\n"; break;
+        case BENCH_NOT: table = "0 1\n"; break;
+        case BENCH_BUFF: table = "1 1\n"; break;
+        default:
+            // minterms of odd (XOR) or even (XNOR) parity
+            for (int minterm = 0; minterm < (1 << num_inputs); ++minterm) {
+                if ((__builtin_popcount(minterm) & 1) != (gate == BENCH_XOR)) {
+                    continue;
+                }
+                for (int i = num_inputs - 1; i >= 0; --i) {
+                    table += ((minterm >> i) & 1) ? '1' : '0';
+                }
+                table += " 1\n";
+            }
+            break;
+    }
+    gate_tables[key] = tables.size();
+    tables.push_back(std::make_pair(num_inputs, table));
+    return tables.size() - 1;
+}
+
+void BenchReader::read()
+{
+    BlifStatement blank;
+    blank.kind = BlifStatement::OTHER;
+    blank.no_table = false;
+    blank.table = -1;
+    blank.table_missing = false;
+    BlifStatement inputs = blank;
+    inputs.kind = BlifStatement::INPUTS;
+    BlifStatement outputs = blank;
+    outputs.kind = BlifStatement::OUTPUTS;
+    vector<BlifStatement> gates;
+
+    const char* pos = file.begin();
+    const char* end = file.end();
+    for (int line = 1; pos < end; ++line) {
+        const char* eol = (const char*)(memchr(pos, '\n', end - pos));
+        if (!eol) {
+            eol = end;
+        }
+        const char* stop = (const char*)(memchr(pos, '#', eol - pos));
+        string_ref text = trim(string_ref(pos, (stop ? stop : eol) - pos));
+        pos = (eol == end) ? end : eol + 1;
+        if (text.empty()) {
+            continue;
+        }
+
+        // <output> = <gate>(<input>, ...) or INPUT(<name>)/OUTPUT(<name>)
+        std::size_t assign = text.find('=');
+        string_ref output;
+        if (assign != string_ref::npos) {
+            output = trim(text.substr(0, assign));
+            text = trim(text.substr(assign + 1));
+        }
+        std::size_t open = text.find('(');
+        if (text.empty() || (open == string_ref::npos) || (text.back() != ')')) {
+            bad_line(line);
+        }
+        string_ref type = trim(text.substr(0, open));
+        string_ref args = text.substr(open + 1, text.size() - open - 2);
+
+        BlifStatement gate = blank;
+        for (;;) {
+            std::size_t comma = args.find(',');
+            string_ref name = trim(args.substr(0, comma));
+            if (name.empty()) {
+                bad_line(line);
+            }
+            gate.names.push_back(name);
+            if (comma == string_ref::npos) {
+                break;
+            }
+            args.remove_prefix(comma + 1);
+        }
+
+        if (output.empty()) {
+            if ((assign != string_ref::npos) || (gate.names.size() != 1)) {
+                bad_line(line);
+            }
+            if (equal_nocase(type, "INPUT")) {
+                inputs.names.push_back(gate.names[0]);
+            } else if (equal_nocase(type, "OUTPUT")) {
+                outputs.names.push_back(gate.names[0]);
+            } else {
+                bad_line(line);
+            }
+            continue;
+        }
+
+        if (equal_nocase(type, "DFF")) {
+            if (gate.names.size() != 1) {
+                bad_line(line);
+            }
+            // .latch <input> <output>
+            gate.kind = BlifStatement::LATCH;
+            gate.names.push_back(output);
+        } else {
+            gate.kind = BlifStatement::NAMES;
+            gate.table = gate_table(type, gate.names.size(), line);
+            gate.names.push_back(output);
+        }
+        gates.push_back(gate);
+    }
+
+    // ports first, as in a BLIF file
+    statements.clear();
+    statements.push_back(inputs);
+    statements.push_back(outputs);
+    statements.insert(statements.end(), gates.begin(), gates.end());
+}
@@ -0,0 +1,60 @@
+#ifndef BENCHREADER_H
+#define BENCHREADER_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <map>
+#include <boost/utility/string_ref.hpp>
+#include "MappedFile.h"
+#include "BlifReader.h"
+
+/*!
+ * Reads an ISCAS .bench netlist as BLIF statements:
+ *
+ *   INPUT(a)
+ *   OUTPUT(z)
+ *   z = NAND(a, b)
+ *
+ * Gates are AND, NAND, OR, NOR, XOR, XNOR, NOT, BUFF (or BUF) and DFF
+ * (any case).  A DFF becomes a latch; every other gate becomes a .names
+ * with the table of the gate.  Names refer into the mapped file.  The
+ * inputs and outputs are returned first, then the gates in file order.
+*/
+class BenchReader {
+  public:
+    /*!
+     * Throws an Error if the file cannot be opened.
+    */
+    BenchReader(const std::string& filename);
+
+    /*!
+     * Read the file.  Throws an Error for a malformed line or an
+     * unknown gate.
+    */
+    void read();
+
+    const std::vector<BlifStatement>& get_statements() const
+    {
+        return statements;
+    }
+
+    //! distinct (number of inputs, truth table) pairs of the statements
+    const std::vector<std::pair<int, std::string> >& get_tables() const
+    {
+        return tables;
+    }
+
+  private:
+    //! index of the table of a gate with the given number of inputs
+    int gate_table(boost::string_ref type, int num_inputs, int line);
+
+    MappedFile file;
+    std::vector<BlifStatement> statements;
+    std::vector<std::pair<int, std::string> > tables;
+
+    //! table of each (gate, number of inputs)
+    std::map<std::pair<int, int>, int> gate_tables;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "BlifReader.h"
+#include "ThreadPool.h"
+
+#include <cstring>
+#include <algorithm>
+#include <tr1/unordered_map>
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+
+using std::string;
+using std::vector;
+using std::pair;
+using std::tr1::unordered_map;
+using boost::string_ref;
+
+//! smallest file split into chunks
+const std::size_t MIN_PARALLEL_SIZE = 1 << 20;
+
+//! smallest chunk when splitting a file
+const std::size_t MIN_CHUNK_SIZE = 1 << 18;
+
+// true for tokens that continue the current line
+static bool is_name_token(int type)
+{
+    return (type == BlifTokenizer::TOKEN_NAME) || (type == BlifTokenizer::TOKEN_KEYWORD);
+}
+
+BlifReader::BlifReader(const string& filename) : file(filename)
+{
+}
+
+void BlifReader::read()
+{
+    const char* begin = file.begin();
+    const char* end = file.end();
+    std::size_t size = end - begin;
+    ThreadPool& pool = ThreadPool::instance();
+
+    int num_parts = 1;
+    if ((pool.get_num_threads() > 1) && (size >= MIN_PARALLEL_SIZE)) {
+        num_parts = std::min(std::size_t(pool.get_num_threads() * 4), size / MIN_CHUNK_SIZE);
+    }
+
+    chunks.clear();
+    const char* chunk_begin = begin;
+    for (int i = 1; i < num_parts; ++i) {
+        const char* target = begin + size / num_parts * i;
+        if (target <= chunk_begin) {
+            continue;
+        }
+        const char* boundary = find_boundary(target, end);
+        if (!boundary) {
+            break;
+        }
+        chunks.push_back(Chunk(chunk_begin, boundary));
+        chunk_begin = boundary;
+    }
+    chunks.push_back(Chunk(chunk_begin, end));
+
+    pool.run(chunks.size(), boost::bind(&BlifReader::read_chunk, this, _1));
+
+    // a chunk starting inside a statement of the previous chunk is
+    // dropped and the rest of the file is read serially
+    for (int i = 1; i < int(chunks.size()); ++i) {
+        if (chunks[i - 1].stop != chunks[i].begin) {
+            const char* stop = chunks[i - 1].stop;
+            chunks.erase(chunks.begin() + i, chunks.end());
+            chunks.push_back(Chunk(stop, end));
+            read_chunk(i);
+            break;
+        }
+    }
+}
+
+void BlifReader::read_chunk(int id)
+{
+    Chunk& chunk = chunks[id];
+    chunk.tokens.reset(new BlifTokenizer(chunk.begin, file.end()));
+    BlifTokenizer& tokens = *(chunk.tokens);
+
+    // each distinct table is looked up in the library once
+    typedef unordered_map<pair<int, string>, int, boost::hash<pair<int, string> > > TableMap;
+    TableMap table_ids;
+    pair<int, string> table_key;
+
+    string_ref token;
+    while (tokens.position() < chunk.end) {
+        int type = tokens.next_token(token);
+        if (type == BlifTokenizer::TOKEN_EOF) {
+            break;
+        } else if (type != BlifTokenizer::TOKEN_KEYWORD) {
+            continue;
+        }
+
+        BlifStatement statement;
+        statement.no_table = false;
+        statement.table = -1;
+        statement.table_missing = false;
+        if (token == ".inputs" || token == ".outputs") {
+            statement.kind = (token == ".inputs") ? BlifStatement::INPUTS : BlifStatement::OUTPUTS;
+            while (is_name_token(tokens.next_token(token))) {
+                statement.names.push_back(token);
+            }
+        } else if (token == ".latch") {
+            // .latch input output [<type> <control>] [<init-val>]
+            // only need input and output
+            statement.kind = BlifStatement::LATCH;
+            tokens.next_token(token);
+            statement.names.push_back(token);
+            tokens.next_token(token);
+            statement.names.push_back(token);
+
+            // Exhaust other token until end-of-line
+            while (is_name_token(tokens.next_token(token)));
+        } else if (token == ".names") {
+            // .names <in-1> <in-2> ... <in-n> <output>
+            statement.kind = BlifStatement::NAMES;
+            while (is_name_token(tokens.next_token(token))) {
+                statement.names.push_back(token);
+            }
+
+            if (tokens.peek() == '.') {
+                statement.no_table = true;
+            } else if (statement.names.size() != 1) {
+                // next one should be truth-table
+                statement.table_missing = (tokens.next_ttable(token) == 1);
+                table_key.first = int(statement.names.size()) - 1;
+                table_key.second.assign(token.data(), token.size());
+                TableMap::iterator iter = table_ids.find(table_key);
+                if (iter == table_ids.end()) {
+                    iter = table_ids.insert(std::make_pair(table_key, int(chunk.tables.size()))).first;
+                    chunk.tables.push_back(table_key);
+                }
+                statement.table = iter->second;
+            }
+        } else {
+            // Not handled. Skip everything until end of line
+            while (is_name_token(tokens.next_token(token))) ;
+            continue;
+        }
+        chunk.statements.push_back(statement);
+    }
+    chunk.stop = tokens.position();
+}
+
+const char* BlifReader::find_boundary(const char* from, const char* limit) const
+{
+    const char* eol = (const char*)(memchr(from, '\n', limit - from));
+    for (; eol && (limit - eol > 7);
+            eol = (const char*)(memchr(eol + 1, '\n', limit - eol - 1))) {
+        const char* next = eol + 1;
+        if ((memcmp(next, ".names", 6) != 0) && (memcmp(next, ".latch", 6) != 0)) {
+            continue;
+        }
+        if ((next[6] != ' ') && (next[6] != '\t')) {
+            continue;
+        }
+
+        // the previous line must be a truth table row
+        const char* line = eol;
+        while ((line > file.begin()) && (line[-1] != '\n')) {
+            --line;
+        }
+        bool row = (line < eol);
+        for (const char* chr = line; row && (chr < eol); ++chr) {
+            row = (*chr == '0') || (*chr == '1') || (*chr == '-') || (*chr == ' ') ||
+                (*chr == '\t') || (*chr == '\r');
+        }
+        if (row) {
+            return next;
+        }
+    }
+    return 0;
+}
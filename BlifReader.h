@@ -0,0 +1,92 @@
+#ifndef BLIFREADER_H
+#define BLIFREADER_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility/string_ref.hpp>
+#include "MappedFile.h"
+#include "BlifTokenizer.h"
+
+/*!
+ * Statement of a BLIF file.  Names refer into the file (or the
+ * tokenizer of the chunk that read the statement).
+*/
+struct BlifStatement {
+    enum Kind { INPUTS, OUTPUTS, LATCH, NAMES, OTHER };
+    Kind kind;
+
+    //! .inputs/.outputs names, latch input and output, or .names inputs then output
+    std::vector<boost::string_ref> names;
+
+    //! .names directly followed by another statement
+    bool no_table;
+
+    //! truth table of a .names (index into the tables of the chunk)
+    int table;
+    bool table_missing;
+};
+
+/*!
+ * Splits a BLIF file into statements.  Large files are cut into chunks
+ * at .names/.latch lines and the chunks are read in parallel by the
+ * thread pool.  A chunk is only used if the previous chunk ended
+ * exactly where it starts, so the statements are always the ones a
+ * serial read produces; otherwise the rest of the file is read
+ * serially.
+*/
+class BlifReader {
+  public:
+    /*!
+     * Throws an Error if the file cannot be opened.
+    */
+    BlifReader(const std::string& filename);
+
+    //! read all statements
+    void read();
+
+    int num_chunks() const
+    {
+        return chunks.size();
+    }
+
+    //! statements of a chunk in file order
+    const std::vector<BlifStatement>& get_statements(int chunk) const
+    {
+        return chunks[chunk].statements;
+    }
+
+    //! distinct (number of inputs, truth table) pairs of a chunk
+    const std::vector<std::pair<int, std::string> >& get_tables(int chunk) const
+    {
+        return chunks[chunk].tables;
+    }
+
+  private:
+    struct Chunk {
+        Chunk(const char* begin_, const char* end_) : begin(begin_), end(end_), stop(0) {}
+
+        //! statements starting in [begin, end) are read
+        const char* begin;
+        const char* end;
+
+        //! start of the first statement not read
+        const char* stop;
+
+        boost::shared_ptr<BlifTokenizer> tokens;
+        std::vector<BlifStatement> statements;
+        std::vector<std::pair<int, std::string> > tables;
+    };
+
+    //! read the statements of a chunk (task for the thread pool)
+    void read_chunk(int id);
+
+    //! start of a .names/.latch line after a truth table row in [from, limit)
+    const char* find_boundary(const char* from, const char* limit) const;
+
+    MappedFile file;
+    std::vector<Chunk> chunks;
+};
+
+#endif
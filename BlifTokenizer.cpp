@@ -0,0 +1,146 @@
+#include "BlifTokenizer.h"
+
+using std::string;
+using boost::string_ref;
+
+void BlifTokenizer::start_token()
+{
+    token_begin = pos;
+    token_size = 0;
+    token_copy = 0;
+}
+
+void BlifTokenizer::append(int chr)
+{
+    if (chr < 0) {
+        return;
+    }
+    if (token_copy) {
+        *token_copy += char(chr);
+        return;
+    }
+
+    // characters are read in order, so the token stays a file range
+    // unless characters were skipped inside it
+    const char* chr_pos = pos - 1;
+    if (token_size == 0) {
+        token_begin = chr_pos;
+        token_size = 1;
+    } else if (token_begin + token_size == chr_pos) {
+        ++token_size;
+    } else {
+        copies.push_back(string(token_begin, token_size));
+        token_copy = &copies.back();
+        *token_copy += char(chr);
+    }
+}
+
+string_ref BlifTokenizer::finish_token()
+{
+    if (token_copy) {
+        return string_ref(*token_copy);
+    }
+    return string_ref(token_begin, token_size);
+}
+
+// return value is: 0: normal token, 1: end-of-line, 2: end-of-file,
+// 4: keyword(.names, .input, .end, etc)
+int BlifTokenizer::next_token(string_ref& token)
+{
+    int chr;
+    int res = TOKEN_NAME;
+    bool in_token = false;
+
+    start_token();
+    token = string_ref();
+
+    // skip heading white space
+    while (!at_eof) {
+        chr = get();
+        if (chr != ' ' && chr != '\t')
+            break;
+    }
+    putback();
+    while (!at_eof) {
+        chr = get();
+        if (chr == '#') {
+            // skip to end-of-line
+            do {
+                chr = get();
+            } while (chr != '\n' && !at_eof);
+            continue;
+        }
+        if (chr == '\r') {
+            chr = get();
+        }
+        if (chr == '\n') {
+            if (in_token) {
+                putback();
+                token = finish_token();
+                return res;
+            } else {
+                return TOKEN_EOL;
+            }
+        }
+        if (chr == '\\') {
+            chr = get();
+            if (chr == '\r') {
+                chr = get();
+            }
+            if (chr == '\n') {
+                chr = get();
+            }
+            if (!in_token) {
+                // skip whitespace
+                while (!at_eof) {
+                    if (chr != ' ' && chr != '\t') {
+                        break;
+                    }
+                    chr = get();
+                }
+            }
+        }
+        if (in_token && (chr == ' ' || chr == '\t')) {
+            token = finish_token();
+            return res;
+        }
+        if (!in_token) {
+            res = (chr == '.') ? TOKEN_KEYWORD : TOKEN_NAME;
+            in_token = true;
+        }
+        append(chr);
+    }
+    token = finish_token();
+    return TOKEN_EOF;
+}
+
+int BlifTokenizer::next_ttable(string_ref& token)
+{
+    int chr;
+    bool skip = false;
+
+    start_token();
+    token = string_ref();
+    chr = get();
+    if (chr == '.') {
+        return 1;
+    }
+    putback();
+
+    // read everything until .
+    while (((chr = get()) != '.') && !at_eof) {
+        if (chr == '#') {
+            // skip # until \n
+            skip = true;
+        }
+        if (!skip) {
+            append(chr);
+        }
+        if (skip && chr == '\n') {
+            skip = false;
+        }
+    }
+    putback();
+    token = finish_token();
+    return 0;
+}
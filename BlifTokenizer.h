@@ -0,0 +1,94 @@
+#ifndef BLIFTOKENIZER_H
+#define BLIFTOKENIZER_H
+
+#include <string>
+#include <deque>
+#include <boost/utility/string_ref.hpp>
+
+/*!
+ * Splits the text of a BLIF file into tokens.  Tokens refer directly
+ * into the text, so no memory is allocated while scanning (only
+ * tokens broken by a line continuation or a comment are copied).
+ * Tokens stay valid for the life of the tokenizer and the text.
+*/
+class BlifTokenizer {
+  public:
+    //! token types returned by next_token()
+    enum TokenType { TOKEN_NAME = 0, TOKEN_EOL = 1, TOKEN_EOF = 2, TOKEN_KEYWORD = 4 };
+
+    /*!
+     * Scan the text [pos_, end_).
+    */
+    BlifTokenizer(const char* pos_, const char* end_) :
+        pos(pos_), end(end_), at_eof(false), token_begin(0), token_size(0),
+        token_copy(0) {}
+
+    /*!
+     * Return the next token and its type.  Keywords start with '.'.
+     * Comments are skipped and a '\' joins a line with the next one.
+    */
+    int next_token(boost::string_ref& token);
+
+    /*!
+     * Return the text up to the next '.' (the truth table of a .names)
+     * with comments removed.  Returns 1 if the text starts with '.'.
+    */
+    int next_ttable(boost::string_ref& token);
+
+    //! next character, or -1 at the end of the file
+    int peek() const
+    {
+        return (pos < end) ? (unsigned char)(*pos) : -1;
+    }
+
+    //! position of the next character
+    const char* position() const
+    {
+        return pos;
+    }
+
+  private:
+    //! not copyable (tokens refer to the copies)
+    BlifTokenizer(const BlifTokenizer&);
+    BlifTokenizer& operator=(const BlifTokenizer&);
+
+    //! next character (-1 and at_eof set at the end of the file)
+    int get()
+    {
+        if (pos < end) {
+            return (unsigned char)(*pos++);
+        }
+        at_eof = true;
+        return -1;
+    }
+
+    //! return the character read by the last get() (not at the end)
+    void putback()
+    {
+        if (!at_eof) {
+            --pos;
+        }
+    }
+
+    //! add the character read by the last get() to the current token
+    void append(int chr);
+
+    //! start an empty token
+    void start_token();
+
+    boost::string_ref finish_token();
+
+    const char* pos;
+    const char* end;
+    bool at_eof;
+
+    //! current token (a range of the file unless it had to be copied)
+    const char* token_begin;
+    std::size_t token_size;
+    std::string* token_copy;
+
+    //! tokens that are not contiguous in the file
+    std::deque<std::string> copies;
+};
+
+#endif
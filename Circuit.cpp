@@ -4,6 +4,14 @@
 #include "Inst.h"
 #include "Port.h"
 #include "TechLibrary.h"
+#include "ThreadPool.h"
+#include "FaultSim.h"
+#include "BlifReader.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+#include "Aiger.h"
+#include "BenchReader.h"
+#include "PatternFile.h"
 
 #include "utils.h"
 
@@ -12,25 +20,60 @@
 #include <cmath>
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <cctype>
+#include <sstream>
 
 #include <fstream>
 #include <string>
 #include <map>
+#include <boost/bind.hpp>
 
 using std::cout; using std::endl;
 using std::string; using std::vector;
 using std::ifstream; using std::ofstream;
 using std::tr1::unordered_set;
+using std::tr1::unordered_map;
 using std::map;
+using std::pair;
+using boost::string_ref;
+
+// true if the file name ends with ext (any case)
+static bool has_extension(const string& filename, const string& ext)
+{
+    if (filename.size() < ext.size()) {
+        return false;
+    }
+    for (int i = 0; i < int(ext.size()); ++i) {
+        if (tolower(filename[filename.size() - ext.size() + i]) != ext[i]) {
+            return false;
+        }
+    }
+    return true;
+}
 
 Circuit::Circuit(string filename, TechLibrary* library_) :
     library(library_), blif_name(filename), num_insts(0), num_wires(0), num_gates(0),
-    num_ports(0), max_level(0), sim_patterns(0), disable_signature_clear(false)
+    num_ports(0), max_level(0), sim_patterns(0), sig_retention(RETAIN_ALL),
+    disable_signature_clear(false)
 {
     // will throw an Error if incorrectly formatted
-    parse_blif(filename);
-
-    levelize();
+    if (is_snapshot_file(filename)) {
+        // saved levelized
+        load_snapshot(filename);
+        compile_sim_program();
+    } else {
+        if (has_extension(filename, ".aig") || has_extension(filename, ".aag")) {
+            parse_aiger(filename);
+        } else if (has_extension(filename, ".bench")) {
+            parse_bench(filename);
+        } else {
+            parse_blif(filename);
+        }
+        // fanout lists grow out of order while parsing
+        netlist.compact();
+        levelize();
+    }
 }
 
 bool sort_wire(Wire* wire1, Wire* wire2)
@@ -38,95 +81,478 @@ bool sort_wire(Wire* wire1, Wire* wire2)
     return (wire1->get_name() < wire2->get_name());
 }
 
+static bool sort_element(CircuitElement* element1, CircuitElement* element2)
+{
+    return (element1->get_name() < element2->get_name());
+}
+
 
 bool Circuit::wires_equal(std::string w1, std::string w2, CoverType type)
 {
-    Wire* wire1 = (Wire*) sym_table[w1];
-    Wire* wire2 = (Wire*) sym_table[w2];
+    return wires_equal(find_wire(w1), find_wire(w2), type);
+}
 
+bool Circuit::wires_equal(Wire* wire1, Wire* wire2, CoverType type)
+{
     return wire1->sig_equiv(*wire2, type); 
 }
 
+CircuitElement* Circuit::find_element(string_ref name)
+{
+    unsigned int name_id = netlist.names.find(name);
+    if (name_id >= symbols.size()) {
+        return 0;
+    }
+    return symbols[name_id];
+}
+
+Wire* Circuit::find_wire(string_ref name)
+{
+    CircuitElement* element = find_element(name);
+    return (element && (element->get_type() == WIRE)) ? (Wire*)(element) : 0;
+}
+
+Inst* Circuit::find_inst(string_ref name)
+{
+    CircuitElement* element = find_element(name);
+    return (element && (element->get_type() == INST)) ? (Inst*)(element) : 0;
+}
+
+void Circuit::match_elements(Circuit& other, vector<Wire*>& wires, vector<Inst*>& insts)
+{
+    wires.assign(other.netlist.num_wires(), 0);
+    for (unsigned int i = 0; i < other.netlist.num_wires(); ++i) {
+        wires[i] = find_wire(other.netlist.get_wire(i)->get_name());
+    }
+    insts.assign(other.netlist.num_insts(), 0);
+    for (unsigned int i = 0; i < other.netlist.num_insts(); ++i) {
+        insts[i] = find_inst(other.netlist.get_inst(i)->get_name());
+    }
+}
+
+void Circuit::add_symbol(CircuitElement* element)
+{
+    unsigned int name_id = element->get_name_id();
+    if (name_id >= symbols.size()) {
+        symbols.resize(std::max(std::size_t(name_id) + 1, 2 * symbols.size()), 0);
+    }
+    symbols[name_id] = element;
+}
+
+
+void Circuit::mark_sources(TraversalMarks& source_marks)
+{
+    for (vector<Wire*>::iterator pwire = input_wires.begin();
+            pwire != input_wires.end(); ++pwire) {
+        source_marks.mark(*pwire);
+    }
+}
+
+//! input_driver() results that are not gate positions
+static const int SOURCE_INPUT = -1;
+static const int UNDRIVEN_INPUT = -2;
+
+//! region_index of gates outside the levelized region
+static const unsigned int NOT_IN_REGION = ~0u;
+
+// orders gates by levelization pass, then by position in lib_insts
+struct PassOrder {
+    PassOrder(const vector<unsigned int>& passes_) : passes(passes_) {}
+    bool operator()(unsigned int pos1, unsigned int pos2) const
+    {
+        return (passes[pos1] < passes[pos2]) ||
+            ((passes[pos1] == passes[pos2]) && (pos1 < pos2));
+    }
+    const vector<unsigned int>& passes;
+};
+
+// name of an instance in levelization errors (its output wire)
+static const string& level_name(Inst* inst)
+{
+    if ((inst->num_outputs() > 0) && inst->get_output(0)->get_wire()) {
+        return inst->get_output(0)->get_wire()->get_name();
+    }
+    return inst->get_name();
+}
 
-/*!
- * Assumes all of the wire/inst visited flags are false
-*/
 void Circuit::levelize()
 {
     max_level= 0;
     linsts.clear();
-    
-    for (vector<Wire*>::iterator pwire = input_wires.begin();
-            pwire != input_wires.end(); ++pwire) {
-	(*pwire)->set_visited(true);
+
+    lib_positions.assign(netlist.num_insts(), -1);
+    level_passes.assign(lib_insts.size(), 0);
+    level_fanouts = ListStore<unsigned int>();
+    level_fanout_lists.assign(lib_insts.size(), ListRange());
+
+    // latches and inputs come first at level 0; the gates are placed
+    vector<unsigned int> region;
+    for (unsigned int i = 0; i < lib_insts.size(); ++i) {
+        Inst* inst = lib_insts[i];
+        lib_positions[inst->get_id()] = i;
+        inst->set_level(0);
+        if (inst->get_is_latch() || inst->is_PI()) {
+            linsts.push_back(inst);
+        } else {
+            region.push_back(i);
+        }
     }
+    levelize_region(region, 0);
+
+    compile_sim_program();
+}
 
-    // Add all latch and inputs to linst; reset level
-    for (vector<Inst*>::iterator pinst= lib_insts.begin();
-            pinst != lib_insts.end(); pinst++) {
-        (*pinst)->set_level(0);
-	if ((*pinst)->get_is_latch() || (*pinst)->is_PI()) {
-	    (*pinst)->set_visited(true);
-	    linsts.push_back(*pinst);
-	}
+void Circuit::levelize_new_insts()
+{
+    // nothing to start from (e.g., a loaded binary netlist)
+    unsigned int first_new = level_passes.size();
+    if (first_new == 0) {
+        levelize();
+        return;
     }
 
-    // Now check all instances, if all its input is valid, add to linsts
-    unsigned int num_iterations = 0;
-    while (linsts.size() < lib_insts.size())
-    {
-        ++num_iterations;
-        // more iterations than instances == problem
-        if (num_iterations > lib_insts.size()) {
-            throw Error("Cannot levelize instances");
-            break;
+    lib_positions.resize(netlist.num_insts(), -1);
+    level_passes.resize(lib_insts.size(), 0);
+    level_fanout_lists.resize(lib_insts.size());
+    marks.start(netlist);
+    vector<unsigned int> region, stack;
+    for (unsigned int i = first_new; i < lib_insts.size(); ++i) {
+        Inst* inst = lib_insts[i];
+        if (inst->get_is_latch() || inst->is_PI()) {
+            levelize();
+            return;
         }
+        lib_positions[inst->get_id()] = i;
+        marks.mark(inst);
+        stack.push_back(i);
+    }
 
-        for (vector<Inst*>::iterator pinst= lib_insts.begin();
-                pinst != lib_insts.end(); pinst++) {
-            Inst* inst2= *pinst;
-            if (inst2->is_visited()) {
+    // the new gates and every gate they feed
+    while (!stack.empty()) {
+        unsigned int pos = stack.back();
+        stack.pop_back();
+        region.push_back(pos);
+        if (pos < first_new) {
+            ListRange& fanout_list = level_fanout_lists[pos];
+            for (unsigned int* pfanout = level_fanouts.begin(fanout_list);
+                    pfanout != level_fanouts.end(fanout_list); ++pfanout) {
+                if (marks.visit(lib_insts[*pfanout])) {
+                    stack.push_back(*pfanout);
+                }
+            }
+            continue;
+        }
+        // the readers of new gates are in the fanout of their outputs
+        Inst* inst = lib_insts[pos];
+        for (Inst::output_iterator pport = inst->output_begin();
+                pport != inst->output_end(); ++pport) {
+            Wire* wire = (*pport)->get_wire();
+            if (!wire) {
                 continue;
             }
-            int max_level2= 0;
-            Inst::input_iterator pport;
-            for (pport = inst2->input_begin();
-                    pport != inst2->input_end(); ++pport) {
-                Wire* wire2= (*pport)->get_wire();
-                if (wire2 && !(wire2->is_visited())) {
-                    break;
+            for (Wire::output_iterator pfanout = wire->output_begin();
+                    pfanout != wire->output_end(); ++pfanout) {
+                Inst* reader = (*pfanout)->get_inst();
+                if (((*pfanout)->get_wire() != wire) || reader->get_is_latch() ||
+                        reader->is_PI()) {
+                    continue;
                 }
-                int curr_level = wire2->get_driver()->get_inst()->get_level();
-                if (max_level2 < curr_level) {
-                    max_level2 = curr_level;
+                int reader_pos = lib_positions[reader->get_id()];
+                if ((reader_pos >= 0) && marks.visit(reader)) {
+                    stack.push_back(reader_pos);
                 }
             }
+        }
+    }
+    levelize_region(region, first_new);
 
-            if (pport == inst2->input_end()) {
-                linsts.push_back(inst2);
-                ++max_level2;
-                inst2->set_level(max_level2);
-                if (max_level < max_level2) {
-                    max_level= max_level2;
-                }
-                inst2->set_visited(true);
-                for (Inst::output_iterator pport= inst2->output_begin();
-                        pport != inst2->output_end(); pport++) {
-                    Wire* wire2= (*pport)->get_wire();
-                    if (wire2) {
-                        wire2->set_visited(true);
-                    }
-                }
+    compile_sim_program();
+}
+
+int Circuit::input_driver(Wire* wire)
+{
+    if (!wire || marks.is_marked(wire)) {
+        return SOURCE_INPUT;
+    }
+    Port* driver = wire->get_driver();
+    if (!driver) {
+        return UNDRIVEN_INPUT;
+    }
+    Inst* inst = driver->get_inst();
+    int pos = (inst->get_id() < lib_positions.size()) ? lib_positions[inst->get_id()] : -1;
+    if ((pos < 0) || inst->get_is_latch() || inst->is_PI()) {
+        return UNDRIVEN_INPUT;
+    }
+    return pos;
+}
+
+void Circuit::levelize_region(vector<unsigned int>& region, unsigned int first_new)
+{
+    // sources are marked; region_index is NOT_IN_REGION outside the
+    // region (and restored when done)
+    marks.start(netlist);
+    mark_sources(marks);
+    region_index.resize(lib_insts.size(), NOT_IN_REGION);
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        region_index[region[r]] = r;
+    }
+
+    // drivers of the inputs of each region gate (resolved once)
+    vector<unsigned int> input_begin(region.size() + 1, 0);
+    vector<int> drivers;
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        Inst* inst = lib_insts[region[r]];
+        for (Inst::input_iterator pport = inst->input_begin();
+                pport != inst->input_end(); ++pport) {
+            drivers.push_back(input_driver((*pport)->get_wire()));
+        }
+        input_begin[r + 1] = drivers.size();
+    }
+
+    // readers of each region gate (by region index) taken from the
+    // inputs, as fanout lists can miss readers of reconnected wires
+    vector<unsigned int> pending(region.size(), 0);
+    vector<unsigned int> reader_begin(region.size() + 1, 0);
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        for (unsigned int i = input_begin[r]; i < input_begin[r + 1]; ++i) {
+            int pos = drivers[i];
+            if ((pos >= 0) && (region_index[pos] != NOT_IN_REGION)) {
+                ++reader_begin[region_index[pos] + 1];
+                ++pending[r];
+            } else if (pos == UNDRIVEN_INPUT) {
+                ++pending[r];
+            }
+        }
+    }
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        reader_begin[r + 1] += reader_begin[r];
+    }
+    vector<unsigned int> readers(reader_begin.back());
+    vector<unsigned int> reader_end(reader_begin.begin(), reader_begin.end() - 1);
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        for (unsigned int i = input_begin[r]; i < input_begin[r + 1]; ++i) {
+            int pos = drivers[i];
+            if ((pos >= 0) && (region_index[pos] != NOT_IN_REGION)) {
+                readers[reader_end[region_index[pos]]++] = r;
+            }
+        }
+    }
+
+    // Kahn: a gate is placed once its drivers are.  Its pass is the
+    // one in which a scan of lib_insts would first find it ready: the
+    // pass of each driver, or the next if the driver comes later.
+    vector<char> placed(region.size(), 0);
+    vector<unsigned int> ready;
+    ready.reserve(region.size());
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        if (pending[r] == 0) {
+            ready.push_back(r);
+        }
+    }
+    for (std::size_t i = 0; i < ready.size(); ++i) {
+        unsigned int r = ready[i];
+        unsigned int pos = region[r];
+        int level = 0;
+        unsigned int pass = 1;
+        for (unsigned int j = input_begin[r]; j < input_begin[r + 1]; ++j) {
+            int driver_pos = drivers[j];
+            if (driver_pos < 0) {
+                continue;
+            }
+            level = std::max(level, lib_insts[driver_pos]->get_level());
+            pass = std::max(pass, level_passes[driver_pos] +
+                    ((unsigned int)(driver_pos) > pos ? 1 : 0));
+        }
+        lib_insts[pos]->set_level(level + 1);
+        level_passes[pos] = pass;
+        placed[r] = 1;
+        for (unsigned int j = reader_begin[r]; j < reader_begin[r + 1]; ++j) {
+            if (--pending[readers[j]] == 0) {
+                ready.push_back(readers[j]);
             }
         }
     }
+    if (ready.size() < region.size()) {
+        string error = unplaced_error(region, placed);
+        for (unsigned int r = 0; r < region.size(); ++r) {
+            region_index[region[r]] = NOT_IN_REGION;
+        }
+        throw Error("Cannot levelize instances: " + error);
+    }
 
-    // clear all the flags, leave the level
-    for (sym_map::iterator iter = sym_table.begin(); 
-            iter != sym_table.end(); ++iter) {
-        (iter->second)->set_visited(false);
+    // remember the readers for levelize_new_insts(); new gates are
+    // also readers of the gates outside the region
+    for (unsigned int j = 0; j < readers.size(); ++j) {
+        readers[j] = region[readers[j]];
+    }
+    const unsigned int* reader_data = readers.empty() ? 0 : &readers[0];
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        level_fanouts.assign(level_fanout_lists[region[r]],
+                reader_data + reader_begin[r], reader_data + reader_begin[r + 1]);
+    }
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        if (region[r] < first_new) {
+            continue;
+        }
+        for (unsigned int i = input_begin[r]; i < input_begin[r + 1]; ++i) {
+            int pos = drivers[i];
+            if ((pos >= 0) && (region_index[pos] == NOT_IN_REGION)) {
+                level_fanouts.push_back(level_fanout_lists[pos], region[r]);
+            }
+        }
+    }
+
+    // merge the region into linsts in (pass, position) order
+    if (first_new == 0) {
+        // the region is in position order: a stable counting sort
+        // by pass is enough
+        unsigned int max_pass = 0;
+        for (unsigned int r = 0; r < region.size(); ++r) {
+            max_pass = std::max(max_pass, level_passes[region[r]]);
+        }
+        vector<unsigned int> pass_begin(max_pass + 2, 0);
+        for (unsigned int r = 0; r < region.size(); ++r) {
+            ++pass_begin[level_passes[region[r]] + 1];
+        }
+        for (unsigned int p = 0; p <= max_pass; ++p) {
+            pass_begin[p + 1] += pass_begin[p];
+        }
+        vector<unsigned int> sorted(region.size());
+        for (unsigned int r = 0; r < region.size(); ++r) {
+            sorted[pass_begin[level_passes[region[r]]]++] = region[r];
+        }
+        region.swap(sorted);
+    } else {
+        std::sort(region.begin(), region.end(), PassOrder(level_passes));
     }
-} 
+
+    PassOrder before(level_passes);
+    vector<Inst*> merged;
+    merged.reserve(linsts.size() + region.size());
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < linsts.size(); ++i) {
+        unsigned int pos = lib_positions[linsts[i]->get_id()];
+        if (region_index[pos] != NOT_IN_REGION) {
+            continue;
+        }
+        while ((next < region.size()) && before(region[next], pos)) {
+            merged.push_back(lib_insts[region[next++]]);
+        }
+        merged.push_back(linsts[i]);
+    }
+    while (next < region.size()) {
+        merged.push_back(lib_insts[region[next++]]);
+    }
+    linsts.swap(merged);
+    for (unsigned int r = 0; r < region.size(); ++r) {
+        region_index[region[r]] = NOT_IN_REGION;
+    }
+
+    max_level = 0;
+    for (std::size_t i = 0; i < linsts.size(); ++i) {
+        max_level = std::max(max_level, linsts[i]->get_level());
+    }
+}
+
+string Circuit::unplaced_error(const vector<unsigned int>& region, const vector<char>& placed)
+{
+    // follow the inputs that were not placed back from an unplaced
+    // gate until a gate repeats (or an input is not driven)
+    vector<int> step(region.size(), -1);
+    vector<unsigned int> path;
+    unsigned int r = std::find(placed.begin(), placed.end(), 0) - placed.begin();
+    while (step[r] < 0) {
+        step[r] = path.size();
+        path.push_back(r);
+        Inst* inst = lib_insts[region[r]];
+        int next = -1;
+        for (Inst::input_iterator pport = inst->input_begin();
+                pport != inst->input_end(); ++pport) {
+            Wire* wire = (*pport)->get_wire();
+            int pos = input_driver(wire);
+            if (pos == UNDRIVEN_INPUT) {
+                return "wire " + wire->get_name() + " is not driven by a gate or an input";
+            }
+            if ((pos >= 0) && (region_index[pos] != NOT_IN_REGION) &&
+                    !placed[region_index[pos]]) {
+                next = region_index[pos];
+                break;
+            }
+        }
+        assert(next >= 0);
+        r = next;
+    }
+
+    // the path runs from readers to their drivers
+    string loop = level_name(lib_insts[region[r]]);
+    for (int i = int(path.size()) - 1; i >= step[r]; --i) {
+        loop += " -> " + level_name(lib_insts[region[path[i]]]);
+    }
+    return "combinational loop through " + loop;
+}
+
+void Circuit::compile_sim_program()
+{
+    sim_program.clear();
+
+    // inputs and gate outputs first to keep the value array in level order
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        sim_program.add_wire(input_wires[i]);
+    }
+    for (int i = 0; i < int(linsts.size()); ++i) {
+        sim_program.add_inst(linsts[i]);
+    }
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        sim_program.add_wire(output_wires[i]);
+    }
+    for (int i = 0; i < int(symbols.size()); ++i) {
+        if (symbols[i] && (symbols[i]->get_type() == WIRE)) {
+            sim_program.add_wire((Wire*)(symbols[i]));
+        }
+    }
+    sim_program.build_fanouts();
+    sim_program.build_native();
+    sim_values.assign(sim_program.num_slots() * sim_program.get_lanes());
+    resim_scheduled.assign(sim_program.num_ops(), false);
+    resim_levels.assign(sim_program.get_max_level() + 1, vector<unsigned int>());
+}
+
+void Circuit::load_sim_values(SimValues& values) const
+{
+    int lanes = sim_program.get_lanes();
+    values.assign(sim_program.num_slots() * lanes);
+    for (unsigned int i = 1; i < sim_program.num_slots(); ++i) {
+        unsigned long long sig = sim_program.get_wire(i)->get_sig_temp();
+        for (int l = 0; l < lanes; ++l) {
+            values[i * lanes + l] = sig;
+        }
+    }
+}
+
+void Circuit::load_signature_inputs(SimValues& values, int word, int num_words) const
+{
+    int lanes = sim_program.get_lanes();
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        unsigned long long* ivalues = values.get() + input_wires[i]->get_slot() * lanes;
+        for (int l = 0; l < lanes; ++l) {
+            ivalues[l] = (word + l < num_words) ? input_wires[i]->get_signature(word + l) : 0;
+        }
+    }
+}
+
+bool Circuit::outputs_differ(SimValues& values, int word, int num_words) const
+{
+    int lanes = sim_program.get_lanes();
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        unsigned long long* ovalues = values.get() + output_wires[i]->get_slot() * lanes;
+        for (int l = 0; (l < lanes) && (word + l < num_words); ++l) {
+            if (ovalues[l] != output_wires[i]->get_signature(word + l)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
 void Circuit::print_info()
 {
@@ -146,303 +572,215 @@ void Circuit::print_info()
 
 // Parse the blif file and build the circuit
 void Circuit::parse_blif(string filename)
+{
+    BlifReader reader(filename);
+    reader.read();
+
+    // elements are created in file order, so the circuit does not
+    // depend on how the file was split for reading
+    for (int chunk = 0; chunk < reader.num_chunks(); ++chunk) {
+        add_statements(reader.get_statements(chunk), reader.get_tables(chunk));
+    }
+    sort(output_wires.begin(), output_wires.end(), sort_wire);
+    sort(input_wires.begin(), input_wires.end(), sort_wire);
+}
+
+void Circuit::parse_aiger(string filename)
+{
+    AigerReader reader(filename);
+    reader.read();
+
+    add_statements(reader.get_statements(), reader.get_tables());
+    sort(output_wires.begin(), output_wires.end(), sort_wire);
+    sort(input_wires.begin(), input_wires.end(), sort_wire);
+}
+
+void Circuit::parse_bench(string filename)
+{
+    BenchReader reader(filename);
+    reader.read();
+
+    add_statements(reader.get_statements(), reader.get_tables());
+    sort(output_wires.begin(), output_wires.end(), sort_wire);
+    sort(input_wires.begin(), input_wires.end(), sort_wire);
+}
+
+void Circuit::add_statements(const vector<BlifStatement>& statements,
+        const vector<pair<int, string> >& tables)
 {
     string latch_str= "1 1\n";
 
-    ifile.open(filename.c_str());
-    if (!ifile) {
-        throw Error("Cannot open file");    
+    vector<lib_cell*> cells(tables.size());
+    for (int i = 0; i < int(tables.size()); ++i) {
+        cells[i] = library->create_libcell(tables[i].second, tables[i].first);
     }
 
-    while (true) {
-        int type;
-        string token;
-        type= get_blif_token(token);
-        if (type == 2) {
-            break;
-        } else if (type == 4) {
-            if (token == ".inputs" || token == ".outputs") {
-                int type= 0;
+    string inst_name;
+    for (int s = 0; s < int(statements.size()); ++s) {
+        const BlifStatement& statement = statements[s];
+        const vector<string_ref>& strvec = statement.names;
+        if (statement.kind == BlifStatement::INPUTS ||
+                statement.kind == BlifStatement::OUTPUTS) {
+            int type= 0;
+
+            if (statement.kind == BlifStatement::OUTPUTS) {
+                type= 1;
+            }
+            for (int i = 0; i < int(strvec.size()); ++i) {
+                // create wire
+                Wire* nwire= netlist.create_wire(strvec[i]);
+                ++num_wires;
+                add_symbol(nwire);
 
-                if (token == ".outputs") {
-                    type= 1;
-                }
-                while (get_blif_token(token) != 1) {
-                    // create wire
-                    Wire* nwire= new Wire(token);
-                    ++num_wires;
-                    sym_table[token]= nwire;
-
-                    // create instance
-                    string instname = token;
-                    instname += type == 0 ? "_input" : "_output";
-                    Inst* ninst= new Inst(instname, true);
-                    ++num_insts;
-                    sym_table[instname]= ninst;
-
-                    // create port
-                    Port* nport= new Port(token);
-                    ++num_ports;
-                    nport->set_inst(ninst);
-                    nport->set_wire(nwire);
-                    
-                    if (type == 0) {
-                        // input, connect port as output
-                        ninst->add_output(nport);
-                        nwire->set_driver(nport);
-                        input_wires.push_back(nwire);
-                    } else {
-                        ninst->add_input(nport);
-                        nwire->add_output_port(nport);
-                        output_wires.push_back(nwire);
-                    }
-                }
-            } else if (token == ".latch") {
-                // .latch input output [<type> <control>] [<init-val>]
-                // only need input and output
-                string input, output;
-                get_blif_token(input);
-                get_blif_token(output);
-                
-                // Exhaust other token until end-of-line
-                while (get_blif_token(token) != 1);
-                
                 // create instance
-                string inst_name = input + "_" + output + "_latch";
-                Inst* ninst= new Inst(inst_name, false, true);
+                inst_name.assign(strvec[i].data(), strvec[i].size());
+                inst_name += type == 0 ? "_input" : "_output";
+                Inst* ninst= netlist.create_inst(inst_name, true);
                 ++num_insts;
-                sym_table[inst_name]= ninst;
-                
-                // handle input port
-                Port* nport= new Port(input);
-                ++num_ports;
-                nport->set_inst(ninst);
-                
-                // create/find wire 
-                Wire* nwire= find_wire_insert(input);
-                nwire->add_output_port(nport);
-                output_wires.push_back(nwire);
-                ninst->add_input(nport);
-                
-                // handle output port
-                nport= new Port(output);
+                add_symbol(ninst);
+
+                // create port
+                Port* nport= netlist.create_port(strvec[i]);
                 ++num_ports;
                 nport->set_inst(ninst);
+                nport->set_wire(nwire);
                 
-                // create/find wire
-                nwire = find_wire_insert(output);
-                if (nwire->get_driver() != 0) {
-                    cout << "Warning, wire " << output
-                        << " has multipler drivers."<<endl;
-                }
-                input_wires.push_back(nwire);
-                nwire->set_driver(nport);
-                ninst->add_output(nport);
-                // latch always has only one input
-                lib_cell* cell = library->create_libcell(latch_str, 1);
-                ninst->add_lib_cell(cell);
-            } else if (token == ".names") {
-                // .names <in-1> <in-2> ... <in-n> <output>
-                vector<string> strvec;
-                int i;
-                string inst_name;
-                
-                Inst* ninst;
-                Port* nport;
-                Wire* nwire;
-
-                while (get_blif_token(token) != 1) {
-                    strvec.push_back(token);
-                    inst_name= inst_name + token + "_";
+                if (type == 0) {
+                    // input, connect port as output
+                    ninst->add_output(nport);
+                    nwire->set_driver(nport);
+                    input_wires.push_back(nwire);
+                } else {
+                    ninst->add_input(nport);
+                    nwire->add_output_port(nport);
+                    output_wires.push_back(nwire);
                 }
+            }
+        } else if (statement.kind == BlifStatement::LATCH) {
+            string_ref input = strvec[0];
+            string_ref output = strvec[1];
+            
+            // create instance
+            inst_name.assign(input.data(), input.size());
+            inst_name += '_';
+            inst_name.append(output.data(), output.size());
+            inst_name += "_latch";
+            Inst* ninst= netlist.create_inst(inst_name, false, true);
+            ++num_insts;
+            add_symbol(ninst);
+            
+            // handle input port
+            Port* nport= netlist.create_port(input);
+            ++num_ports;
+            nport->set_inst(ninst);
+            
+            // create/find wire 
+            Wire* nwire= find_wire_insert(input);
+            nwire->add_output_port(nport);
+            output_wires.push_back(nwire);
+            ninst->add_input(nport);
+            
+            // handle output port
+            nport= netlist.create_port(output);
+            ++num_ports;
+            nport->set_inst(ninst);
+            
+            // create/find wire
+            nwire = find_wire_insert(output);
+            if (nwire->get_driver() != 0) {
+                cout << "Warning, wire " << output
+                    << " has multipler drivers."<<endl;
+            }
+            input_wires.push_back(nwire);
+            nwire->set_driver(nport);
+            ninst->add_output(nport);
+            // latch always has only one input
+            lib_cell* cell = library->create_libcell(latch_str, 1);
+            ninst->add_lib_cell(cell);
+        } else if (statement.kind == BlifStatement::NAMES) {
+            int i;
+            
+            Inst* ninst;
+            Port* nport;
+            Wire* nwire;
+
+            // "<in-1>_..._<in-n>_<output>_name"
+            inst_name.clear();
+            for (i = 0; i < int(strvec.size()); ++i) {
+                inst_name.append(strvec[i].data(), strvec[i].size());
+                inst_name += '_';
+            }
 
-                char chr_temp= ifile.get();
-                ifile.putback(chr_temp);
-                if (chr_temp == '.') {
-                    cout<<"Warning, instance "<<inst_name<<" has no truth table."<<endl;
-                    if(strvec.size() == 1) {
-                        zero_list.insert(strvec[0]);
-                        nwire = find_wire_insert(strvec[0]);
-                        throw Error("Found a constant 0");
-                        constants_list.push_back(nwire);
-                    }
-                    continue;
-                }
+            if (statement.no_table) {
+                cout<<"Warning, instance "<<inst_name<<" has no truth table."<<endl;
                 if(strvec.size() == 1) {
-                    cout << "Warning, constant wire " << inst_name << endl;
-                    one_list.insert(strvec[0]);
-                    nwire= find_wire_insert(strvec[0]);
-                    throw Error("Found a constant 1");
+                    zero_list.insert(strvec[0].to_string());
+                    nwire = find_wire_insert(strvec[0]);
+                    throw Error("Found a constant 0");
                     constants_list.push_back(nwire);
-                    continue;
                 }
-
-                // set instance
-                inst_name= inst_name + "name";
-                ninst= new Inst(inst_name);
-                lib_insts.push_back(ninst);
-                ++num_insts;
-                ++num_gates;
-                sym_table[inst_name]= ninst;
-                
-                // first n-1 names are inputs
-                for (i= 0; i < int(strvec.size()) - 1; i++) {
-                    nport= new Port(strvec[i]);
-                    ++num_ports;
-                    nwire= find_wire_insert(strvec[i]);
-                    nwire->add_output_port(nport);
-                    ninst->add_input(nport);
-                    nport->set_inst(ninst);
-                }
-                
-                // last name is output
-                int size= strvec.size();
-                nport= new Port(strvec[size-1]);
-                ++num_ports;
-                nport->set_inst(ninst);
-                nwire= find_wire_insert(strvec[size-1]);
-                ninst->add_output(nport);
-                if (nwire->get_driver() != 0) {
-                    cout<<"Warning, wire "<<strvec[size - 1]<<" has multiple drivers."<<endl;
-                }
-                nwire->set_driver(nport);
-                
-                // next one should be truth-table
-                if (get_blif_ttable(token) == 1) { 
-                    cout<<"Warning, instance "<<inst_name<<" has no truth table."<<endl;
-                }
-                lib_cell* cell = library->create_libcell(token, 
-                        ninst->num_inputs());
-                ninst->add_lib_cell(cell);
-            } else {
-                // Not handled. Skip everything until end of line
-                while (get_blif_token(token) != 1) ;
-            }
-        }
-    }
-    ifile.close();
-    sort(output_wires.begin(), output_wires.end(), sort_wire);
-    sort(input_wires.begin(), input_wires.end(), sort_wire);
-}
-
-// return blif token in token. return value is: 0: normal token, 1: end-of-line,
-// 2: end-of-file, 4: keyword(.names, .input, .end, etc)
-int Circuit::get_blif_token(string& token)
-{
-    int chr;
-    int res;
-    bool in_token= false;
-
-    token.clear();
-    // skip heading white space
-    while (ifile) {
-        chr= ifile.get();
-        if (chr != ' ' && chr != '\t')
-            break;
-    }
-    ifile.putback(chr);
-    while (ifile) {
-        chr= ifile.get();
-        if (chr == '#') {
-            // skip to end-of-line
-            do {
-                chr= ifile.get();
-            } while (chr != '\n' && ifile.eof() == false);
-            continue;
-        }
-        if (chr == '\r') {
-            chr= ifile.get();
-        }
-        if (chr == '\n') {
-            if (in_token == true) {
-                ifile.putback(chr);
-                return res;
-            } else {
-                return 1;
+                continue;
             }
-        }
-        if (chr == '\\') {
-            chr= ifile.get();
-            if (chr == '\r') {
-                chr= ifile.get();
+            if(strvec.size() == 1) {
+                cout << "Warning, constant wire " << inst_name << endl;
+                one_list.insert(strvec[0].to_string());
+                nwire= find_wire_insert(strvec[0]);
+                throw Error("Found a constant 1");
+                constants_list.push_back(nwire);
+                continue;
             }
-            if (chr == '\n') {
-                chr= ifile.get();
+            inst_name += "name";
+
+            // set instance
+            ninst= netlist.create_inst(inst_name);
+            lib_insts.push_back(ninst);
+            ++num_insts;
+            ++num_gates;
+            add_symbol(ninst);
+            
+            // first n-1 names are inputs
+            for (i= 0; i < int(strvec.size()) - 1; i++) {
+                nport= netlist.create_port(strvec[i]);
+                ++num_ports;
+                nwire= find_wire_insert(strvec[i]);
+                nwire->add_output_port(nport);
+                ninst->add_input(nport);
+                nport->set_inst(ninst);
             }
-            if (in_token == false) {
-                // skip whitespace
-                while (ifile.eof() == false) {
-                    if (chr != ' ' && chr != '\t') {
-                        break;
-                    }
-                    chr= ifile.get();
-                } 
+            
+            // last name is output
+            string_ref output = strvec.back();
+            nport= netlist.create_port(output);
+            ++num_ports;
+            nport->set_inst(ninst);
+            nwire= find_wire_insert(output);
+            ninst->add_output(nport);
+            if (nwire->get_driver() != 0) {
+                cout<<"Warning, wire "<<output<<" has multiple drivers."<<endl;
             }
-        }
-        if (in_token && (chr == ' ' || chr == '\t')) {
-            return res;
-        }
-        if (!in_token) {
-            if (chr == '.') {
-                res= 4;
-            } else {
-                res= 0;
+            nwire->set_driver(nport);
+            
+            if (statement.table_missing) { 
+                cout<<"Warning, instance "<<inst_name<<" has no truth table."<<endl;
             }
-            in_token= true;
-        }
-        token= token + (char)chr;
-    }
-    return 2;
-}
-
-// return truth table. If it starts with ".", return 1. Otherwise return 0.
-int Circuit::get_blif_ttable(string& token)
-{
-    int chr;
-    bool skip;
-
-    // skip heading white space
-    chr= ifile.get();
-    if (chr == '.')
-        return 1;
-    else
-        ifile.putback(chr);
-    token.clear();
-    // Read everything until .
-    skip= false;
-    while (ifile && (chr= ifile.get()) != '.')
-    {
-        if (chr == '#') {
-            // skip # until \n
-            skip= true;
-        }
-        if (skip == false) {
-            token= token + (char)chr;
+            ninst->add_lib_cell(cells[statement.table]);
         }
-        if (skip == true && chr == '\n') {
-            skip= false;
-        }
-    }
-    if (ifile) {
-        ifile.putback(chr);
     }
-    return 0;
 }
 
 // Find a wire from symble table. If found, return it.
 // Otherwise create a wire, add to symble table, and return it.
-Wire* Circuit::find_wire_insert(string& name)
+Wire* Circuit::find_wire_insert(string_ref name)
 {
-    sym_map::iterator pmap;
     Wire* nwire;
     
-    pmap= sym_table.find(name);
-    if (pmap == sym_table.end()) {
-        nwire= new Wire(name);
+    CircuitElement* element = find_element(name);
+    if (!element) {
+        nwire= netlist.create_wire(name);
         ++num_wires;
-        sym_table[name]= nwire;
+        add_symbol(nwire);
     } else {
-        nwire= (Wire*)(*pmap).second;
+        nwire= (Wire*)(element);
     }
     return nwire;
 }
@@ -450,7 +788,7 @@ Wire* Circuit::find_wire_insert(string& name)
 // Write blif file from netlist
 void Circuit::write_blif(string filename)
 {
-    map<string, CircuitElement*>::iterator pmap;
+    vector<CircuitElement*>::iterator pmap;
     CircuitElement* element;
     Inst* inst2;
     Port* port2;
@@ -478,13 +816,20 @@ void Circuit::write_blif(string filename)
         model_name = model_name.substr(0, last_index);
     }
 
-    map<string, CircuitElement*> sym_table_map(sym_table.begin(), sym_table.end());
+    // elements in name order
+    vector<CircuitElement*> sym_table_map;
+    for (int i = 0; i < int(symbols.size()); ++i) {
+        if (symbols[i]) {
+            sym_table_map.push_back(symbols[i]);
+        }
+    }
+    sort(sym_table_map.begin(), sym_table_map.end(), sort_element);
 
     bliffile <<".model " << model_name << endl;
     // inputs
     bliffile<<".inputs ";
     for (pmap= sym_table_map.begin(); pmap != sym_table_map.end(); pmap++) {
-        element = (*pmap).second;
+        element = *pmap;
         if (element->get_type() == INST) {
             inst2 = (Inst*)(element);
             if ((inst2->get_is_latch() || inst2->get_is_port()) && (inst2->num_outputs() > 0)) {
@@ -513,7 +858,7 @@ void Circuit::write_blif(string filename)
     bliffile<<endl;
     bliffile<<".outputs ";
     for (pmap= sym_table_map.begin(); pmap != sym_table_map.end(); pmap++) {
-        element = (*pmap).second;
+        element = *pmap;
         if (element->get_type() == INST) {
             inst2 = (Inst*)(element);
             if ((inst2->get_is_latch() || inst2->get_is_port()) && (inst2->num_inputs() > 0)) {
@@ -544,7 +889,7 @@ void Circuit::write_blif(string filename)
 
     // names, latch
     for (pmap= sym_table_map.begin(); pmap != sym_table_map.end(); pmap++) {
-        element = (*pmap).second;
+        element = *pmap;
         if (element->get_type() == INST) {
             inst2= (Inst*) element;
             for (i = 0; i < int(inst2->num_outputs()); ++i) {
@@ -634,16 +979,524 @@ void Circuit::write_blif(string filename)
             }
         }
     }
-    bliffile<<".end"<<endl;
-    bliffile.close();
+    bliffile<<".end"<<endl;
+    bliffile.close();
+}
+
+// AIGER literal of a cell output from the literals of its inputs
+static unsigned int cell_literal(AigerWriter& aig, const lib_cell* cell,
+        const vector<unsigned int>& inputs)
+{
+    if (cell->has_kernel()) {
+        const vector<CellOp>& kernel = cell->get_kernel();
+        vector<unsigned int> regs(2 + inputs.size() + kernel.size());
+        regs[0] = 0;
+        regs[1] = 1;
+        std::copy(inputs.begin(), inputs.end(), regs.begin() + 2);
+        for (int i = 0; i < int(kernel.size()); ++i) {
+            const CellOp& kop = kernel[i];
+            unsigned int a = regs[kop.a];
+            unsigned int b = regs[kop.b];
+            unsigned int& result = regs[2 + inputs.size() + i];
+            switch (kop.code) {
+                case CellOp::AND: result = aig.add_and(a, b); break;
+                case CellOp::OR: result = aig.add_or(a, b); break;
+                case CellOp::XOR: result = aig.add_xor(a, b); break;
+                case CellOp::ANDN: result = aig.add_and(a, b ^ 1); break;
+                case CellOp::ORN: result = aig.add_or(a, b ^ 1); break;
+                default: result = aig.add_mux(regs[kop.c], a, b); break;
+            }
+        }
+        return regs[cell->get_kernel_out()];
+    }
+
+    // the first matching cube decides the output
+    unsigned int result = cell->get_cover_default() ? 1 : 0;
+    for (int i = cell->num_cubes() - 1; i >= 0; --i) {
+        unsigned int match = 1;
+        for (const unsigned int* lit = cell->cube_begin(i); lit != cell->cube_end(i); ++lit) {
+            match = aig.add_and(match, inputs[*lit >> 1] ^ ((*lit & 1) ^ 1));
+        }
+        if (cell->get_cube_output(i)) {
+            result = aig.add_or(match, result);
+        } else {
+            result = aig.add_and(match ^ 1, result);
+        }
+    }
+    return result;
+}
+
+void Circuit::write_aiger(string filename)
+{
+    KeySection keys;
+    get_key_section(keys);
+
+    AigerWriter aig;
+    unordered_map<Wire*, unsigned int> lits;
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        lits[input_wires[i]] = aig.add_input(input_wires[i]->get_name());
+    }
+    for (int i = 0; i < int(keys.wires.size()); ++i) {
+        lits[keys.wires[i]] = aig.add_input(keys.wires[i]->get_name());
+    }
+
+    vector<unsigned int> inputs;
+    for (int i = 0; i < int(linsts.size()); ++i) {
+        Inst* inst = linsts[i];
+        if (inst->get_is_latch() || inst->get_is_port()) {
+            continue;
+        }
+        inputs.clear();
+        for (unsigned int j = 0; j < inst->num_inputs(); ++j) {
+            Wire* wire = inst->get_input(j)->get_wire();
+            unordered_map<Wire*, unsigned int>::iterator iter = lits.find(wire);
+            if (iter == lits.end()) {
+                throw Error("Cannot write AIGER: " + inst->get_name() + " has an undriven input");
+            }
+            inputs.push_back(iter->second);
+        }
+        for (unsigned int j = 0; j < inst->num_outputs(); ++j) {
+            Wire* wire = inst->get_output(j)->get_wire();
+            if (wire) {
+                lits[wire] = cell_literal(aig, inst->get_libcell(j), inputs);
+            }
+        }
+    }
+
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        unordered_map<Wire*, unsigned int>::iterator iter = lits.find(output_wires[i]);
+        if (iter == lits.end()) {
+            throw Error("Cannot write AIGER: output " + output_wires[i]->get_name() +
+                    " is undriven");
+        }
+        aig.add_output(iter->second, output_wires[i]->get_name());
+    }
+
+    // key inputs follow the primary inputs
+    for (int i = 0; i < int(keys.wires.size()); ++i) {
+        std::stringstream line;
+        line << "key input i" << input_wires.size() + i << " " << keys.wires[i]->get_name();
+        aig.add_comment(line.str());
+    }
+    aig.write(filename);
+}
+
+namespace {
+
+//! numbers the elements of a circuit in the order they are reached
+struct SnapshotIds {
+    vector<Inst*> insts;
+    vector<Wire*> wires;
+    vector<Port*> ports;
+    vector<lib_cell*> cells;
+    unordered_map<const void*, uint32_t> ids;
+
+    template <class T>
+    uint32_t id(T* elem, vector<T*>& elems)
+    {
+        if (!elem) {
+            return SNAPSHOT_NONE;
+        }
+        pair<unordered_map<const void*, uint32_t>::iterator, bool> res =
+            ids.insert(std::make_pair((const void*)(elem), uint32_t(elems.size())));
+        if (res.second) {
+            elems.push_back(elem);
+        }
+        return res.first->second;
+    }
+
+    uint32_t id(Inst* inst) { return id(inst, insts); }
+    uint32_t id(Wire* wire) { return id(wire, wires); }
+    uint32_t id(Port* port) { return id(port, ports); }
+    uint32_t id(lib_cell* cell) { return id(cell, cells); }
+};
+
+//! string section of a binary netlist (equal strings are stored once)
+struct SnapshotStrings {
+    vector<SnapshotString> entries;
+    string bytes;
+    unordered_map<string, uint32_t> ids;
+
+    uint32_t id(const string& str)
+    {
+        pair<unordered_map<string, uint32_t>::iterator, bool> res =
+            ids.insert(std::make_pair(str, uint32_t(entries.size())));
+        if (res.second) {
+            SnapshotString entry;
+            entry.offset = bytes.size();
+            entry.size = str.size();
+            entries.push_back(entry);
+            bytes += str;
+        }
+        return res.first->second;
+    }
+};
+
+template <class T>
+void write_snapshot_array(ofstream& fout, const vector<T>& elems)
+{
+    if (!elems.empty()) {
+        fout.write((const char*)(&elems[0]), elems.size() * sizeof(T));
+    }
+}
+
+//! next count records of a binary netlist section
+template <class T>
+const T* read_snapshot_array(const char*& pos, const char* end, uint32_t count)
+{
+    if (std::size_t(end - pos) / sizeof(T) < count) {
+        throw Error("Invalid binary netlist");
+    }
+    const T* elems = (const T*)(pos);
+    pos += count * sizeof(T);
+    return elems;
+}
+
+//! element of a binary netlist index (0 for SNAPSHOT_NONE if allowed)
+template <class T>
+T* snapshot_element(const vector<T*>& elems, uint32_t id, bool allow_none = false)
+{
+    if (allow_none && (id == SNAPSHOT_NONE)) {
+        return 0;
+    }
+    if (id >= elems.size()) {
+        throw Error("Invalid binary netlist");
+    }
+    return elems[id];
+}
+
+const string& snapshot_string(const vector<string>& strings, uint32_t id)
+{
+    if (id >= strings.size()) {
+        throw Error("Invalid binary netlist");
+    }
+    return strings[id];
+}
+
+}
+
+void Circuit::write_snapshot(string filename)
+{
+    KeySection keys;
+    get_key_section(keys);
+
+    SnapshotIds ids;
+    SnapshotStrings strings;
+
+    // the symbol table and the lists reach every element
+    vector<SnapshotSymbol> symbol_records;
+    for (int i = 0; i < int(symbols.size()); ++i) {
+        CircuitElement* element = symbols[i];
+        if (!element) {
+            continue;
+        }
+        SnapshotSymbol symbol;
+        symbol.name = strings.id(netlist.names.get(i));
+        symbol.type = element->get_type();
+        if (symbol.type == WIRE) {
+            symbol.id = ids.id((Wire*)(element));
+        } else {
+            symbol.id = ids.id((Inst*)(element));
+        }
+        symbol_records.push_back(symbol);
+    }
+
+    vector<uint32_t> lists[6];
+    for (int i = 0; i < int(lib_insts.size()); ++i) {
+        lists[0].push_back(ids.id(lib_insts[i]));
+    }
+    for (int i = 0; i < int(linsts.size()); ++i) {
+        lists[1].push_back(ids.id(linsts[i]));
+    }
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        lists[2].push_back(ids.id(input_wires[i]));
+    }
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        lists[3].push_back(ids.id(output_wires[i]));
+    }
+    for (int i = 0; i < int(keys.wires.size()); ++i) {
+        lists[4].push_back(ids.id(keys.wires[i]));
+    }
+    vector<uint32_t> key_values(keys.values.begin(), keys.values.end());
+    for (int i = 0; i < int(keys.new_gates.size()); ++i) {
+        lists[5].push_back(ids.id(keys.new_gates[i]));
+    }
+
+    // records are made in index order; new elements are numbered as
+    // their neighbors are visited
+    vector<SnapshotInst> insts;
+    vector<SnapshotWire> wires;
+    vector<SnapshotPort> ports;
+    vector<uint32_t> links;
+    while ((insts.size() < ids.insts.size()) || (wires.size() < ids.wires.size()) ||
+            (ports.size() < ids.ports.size())) {
+        while (insts.size() < ids.insts.size()) {
+            Inst* inst = ids.insts[insts.size()];
+            SnapshotInst record;
+            record.name = strings.id(inst->get_name());
+            record.flags = (inst->get_is_port() ? SNAPSHOT_INST_PORT : 0) |
+                (inst->get_is_latch() ? SNAPSHOT_INST_LATCH : 0);
+            record.level = inst->get_level();
+            record.num_inputs = inst->num_inputs();
+            record.num_outputs = inst->num_outputs();
+            record.num_cells = inst->num_lib_cells();
+            record.links = links.size();
+            for (unsigned int i = 0; i < inst->num_inputs(); ++i) {
+                links.push_back(ids.id(inst->get_input(i)));
+            }
+            for (unsigned int i = 0; i < inst->num_outputs(); ++i) {
+                links.push_back(ids.id(inst->get_output(i)));
+            }
+            for (unsigned int i = 0; i < inst->num_lib_cells(); ++i) {
+                links.push_back(ids.id(inst->get_libcell(i)));
+            }
+            insts.push_back(record);
+        }
+        while (wires.size() < ids.wires.size()) {
+            Wire* wire = ids.wires[wires.size()];
+            SnapshotWire record;
+            record.name = strings.id(wire->get_name());
+            record.driver = ids.id(wire->get_driver());
+            record.num_outputs = wire->num_outputs();
+            record.links = links.size();
+            record.sig_temp_low = uint32_t(wire->get_sig_temp());
+            record.sig_temp_high = uint32_t(wire->get_sig_temp() >> 32);
+            for (unsigned int i = 0; i < wire->num_outputs(); ++i) {
+                links.push_back(ids.id(wire->get_output(i)));
+            }
+            wires.push_back(record);
+        }
+        while (ports.size() < ids.ports.size()) {
+            Port* port = ids.ports[ports.size()];
+            SnapshotPort record;
+            record.name = strings.id(port->get_name());
+            record.inst = ids.id(port->get_inst());
+            record.wire = ids.id(port->get_wire());
+            ports.push_back(record);
+        }
+    }
+
+    vector<SnapshotCell> cells;
+    for (int i = 0; i < int(ids.cells.size()); ++i) {
+        SnapshotCell record;
+        record.num_inputs = ids.cells[i]->get_num_inputs();
+        record.table = strings.id(ids.cells[i]->get_blif());
+        cells.push_back(record);
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.num_strings = strings.entries.size();
+    header.num_cells = cells.size();
+    header.num_insts = insts.size();
+    header.num_wires = wires.size();
+    header.num_ports = ports.size();
+    header.num_symbols = symbol_records.size();
+    header.num_links = links.size();
+    header.num_lib_insts = lists[0].size();
+    header.num_linsts = lists[1].size();
+    header.num_input_wires = lists[2].size();
+    header.num_output_wires = lists[3].size();
+    header.num_key_wires = lists[4].size();
+    header.num_new_gates = lists[5].size();
+    header.string_bytes = strings.bytes.size();
+    header.inst_count = num_insts;
+    header.wire_count = num_wires;
+    header.gate_count = num_gates;
+    header.port_count = num_ports;
+    header.max_level = max_level;
+
+    ofstream fout(filename.c_str(), std::ios::binary);
+    if (!fout) {
+        throw Error("Cannot write binary netlist");
+    }
+    fout.write((const char*)(&header), sizeof(header));
+    write_snapshot_array(fout, strings.entries);
+    write_snapshot_array(fout, cells);
+    write_snapshot_array(fout, insts);
+    write_snapshot_array(fout, wires);
+    write_snapshot_array(fout, ports);
+    write_snapshot_array(fout, symbol_records);
+    write_snapshot_array(fout, links);
+    for (int i = 0; i < 5; ++i) {
+        write_snapshot_array(fout, lists[i]);
+    }
+    write_snapshot_array(fout, key_values);
+    write_snapshot_array(fout, lists[5]);
+    fout.write(strings.bytes.data(), strings.bytes.size());
+    if (!fout) {
+        throw Error("Cannot write binary netlist");
+    }
+}
+
+void Circuit::load_snapshot(string filename)
+{
+    MappedFile file(filename);
+    const char* pos = file.begin();
+    const char* end = file.end();
+
+    const SnapshotHeader& header = *read_snapshot_array<SnapshotHeader>(pos, end, 1);
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw Error("Invalid binary netlist");
+    }
+    if (header.byte_order != SNAPSHOT_BYTE_ORDER) {
+        throw Error("Binary netlist was written on a host with another byte order");
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw Error("Unsupported binary netlist version");
+    }
+
+    const SnapshotString* string_entries =
+        read_snapshot_array<SnapshotString>(pos, end, header.num_strings);
+    const SnapshotCell* cell_records = read_snapshot_array<SnapshotCell>(pos, end, header.num_cells);
+    const SnapshotInst* inst_records = read_snapshot_array<SnapshotInst>(pos, end, header.num_insts);
+    const SnapshotWire* wire_records = read_snapshot_array<SnapshotWire>(pos, end, header.num_wires);
+    const SnapshotPort* port_records = read_snapshot_array<SnapshotPort>(pos, end, header.num_ports);
+    const SnapshotSymbol* symbol_records =
+        read_snapshot_array<SnapshotSymbol>(pos, end, header.num_symbols);
+    const uint32_t* links = read_snapshot_array<uint32_t>(pos, end, header.num_links);
+    const uint32_t* lib_inst_ids = read_snapshot_array<uint32_t>(pos, end, header.num_lib_insts);
+    const uint32_t* linst_ids = read_snapshot_array<uint32_t>(pos, end, header.num_linsts);
+    const uint32_t* input_ids = read_snapshot_array<uint32_t>(pos, end, header.num_input_wires);
+    const uint32_t* output_ids = read_snapshot_array<uint32_t>(pos, end, header.num_output_wires);
+    const uint32_t* key_ids = read_snapshot_array<uint32_t>(pos, end, header.num_key_wires);
+    const uint32_t* key_values = read_snapshot_array<uint32_t>(pos, end, header.num_key_wires);
+    const uint32_t* new_gate_ids = read_snapshot_array<uint32_t>(pos, end, header.num_new_gates);
+    const char* bytes = read_snapshot_array<char>(pos, end, header.string_bytes);
+    if (pos != end) {
+        throw Error("Invalid binary netlist");
+    }
+
+    vector<string> strings(header.num_strings);
+    for (uint32_t i = 0; i < header.num_strings; ++i) {
+        const SnapshotString& entry = string_entries[i];
+        if ((entry.offset > header.string_bytes) ||
+                (entry.size > header.string_bytes - entry.offset)) {
+            throw Error("Invalid binary netlist");
+        }
+        strings[i].assign(bytes + entry.offset, entry.size);
+    }
+    // create the elements, then connect them
+    vector<lib_cell*> cells(header.num_cells);
+    for (uint32_t i = 0; i < header.num_cells; ++i) {
+        cells[i] = library->create_libcell(snapshot_string(strings, cell_records[i].table),
+                cell_records[i].num_inputs);
+    }
+    vector<Inst*> insts(header.num_insts);
+    for (uint32_t i = 0; i < header.num_insts; ++i) {
+        const SnapshotInst& record = inst_records[i];
+        insts[i] = netlist.create_inst(snapshot_string(strings, record.name),
+                record.flags & SNAPSHOT_INST_PORT, record.flags & SNAPSHOT_INST_LATCH);
+        insts[i]->set_level(record.level);
+    }
+    vector<Wire*> wires(header.num_wires);
+    for (uint32_t i = 0; i < header.num_wires; ++i) {
+        const SnapshotWire& record = wire_records[i];
+        wires[i] = netlist.create_wire(snapshot_string(strings, record.name));
+        wires[i]->set_sig_temp((((unsigned long long)(record.sig_temp_high)) << 32) |
+                record.sig_temp_low);
+    }
+    vector<Port*> ports(header.num_ports);
+    for (uint32_t i = 0; i < header.num_ports; ++i) {
+        ports[i] = netlist.create_port(snapshot_string(strings, port_records[i].name));
+    }
+
+    for (uint32_t i = 0; i < header.num_insts; ++i) {
+        const SnapshotInst& record = inst_records[i];
+        uint32_t num_links = record.num_inputs + record.num_outputs + record.num_cells;
+        if ((record.links > header.num_links) || (num_links > header.num_links - record.links)) {
+            throw Error("Invalid binary netlist");
+        }
+        const uint32_t* link = links + record.links;
+        for (uint32_t j = 0; j < record.num_inputs; ++j) {
+            insts[i]->add_input(snapshot_element(ports, *link++));
+        }
+        for (uint32_t j = 0; j < record.num_outputs; ++j) {
+            insts[i]->add_output(snapshot_element(ports, *link++));
+        }
+        for (uint32_t j = 0; j < record.num_cells; ++j) {
+            insts[i]->add_lib_cell(snapshot_element(cells, *link++));
+        }
+    }
+    for (uint32_t i = 0; i < header.num_wires; ++i) {
+        const SnapshotWire& record = wire_records[i];
+        if ((record.links > header.num_links) ||
+                (record.num_outputs > header.num_links - record.links)) {
+            throw Error("Invalid binary netlist");
+        }
+        const uint32_t* link = links + record.links;
+        for (uint32_t j = 0; j < record.num_outputs; ++j) {
+            wires[i]->add_output_port(snapshot_element(ports, link[j]));
+        }
+        Port* driver = snapshot_element(ports, record.driver, true);
+        if (driver) {
+            wires[i]->set_driver(driver);
+        }
+    }
+
+    // set last: a port does not always refer back to its owners
+    for (uint32_t i = 0; i < header.num_ports; ++i) {
+        ports[i]->set_inst(snapshot_element(insts, port_records[i].inst, true));
+        ports[i]->set_wire(snapshot_element(wires, port_records[i].wire, true));
+    }
+
+    for (uint32_t i = 0; i < header.num_symbols; ++i) {
+        const SnapshotSymbol& record = symbol_records[i];
+        CircuitElement* elem;
+        if (record.type == WIRE) {
+            elem = snapshot_element(wires, record.id);
+        } else if (record.type == INST) {
+            elem = snapshot_element(insts, record.id);
+        } else {
+            throw Error("Invalid binary netlist");
+        }
+        unsigned int name_id = netlist.names.intern(snapshot_string(strings, record.name));
+        if (name_id >= symbols.size()) {
+            symbols.resize(name_id + 1, 0);
+        }
+        symbols[name_id] = elem;
+    }
+
+    for (uint32_t i = 0; i < header.num_lib_insts; ++i) {
+        lib_insts.push_back(snapshot_element(insts, lib_inst_ids[i]));
+    }
+    for (uint32_t i = 0; i < header.num_linsts; ++i) {
+        linsts.push_back(snapshot_element(insts, linst_ids[i]));
+    }
+    for (uint32_t i = 0; i < header.num_input_wires; ++i) {
+        input_wires.push_back(snapshot_element(wires, input_ids[i]));
+    }
+    for (uint32_t i = 0; i < header.num_output_wires; ++i) {
+        output_wires.push_back(snapshot_element(wires, output_ids[i]));
+    }
+    for (uint32_t i = 0; i < header.num_key_wires; ++i) {
+        loaded_keys.wires.push_back(snapshot_element(wires, key_ids[i]));
+        loaded_keys.values.push_back(key_values[i]);
+    }
+    for (uint32_t i = 0; i < header.num_new_gates; ++i) {
+        loaded_keys.new_gates.push_back(snapshot_element(insts, new_gate_ids[i]));
+    }
+
+    num_insts = header.inst_count;
+    num_wires = header.wire_count;
+    num_gates = header.gate_count;
+    num_ports = header.port_count;
+    max_level = header.max_level;
 }
 
 
 // Check if port is in driver's input cone. Return true if yes.
 bool Circuit::check_input_cone(Port* port2, Port* driver)
 {
-    vector<Inst*> stack, stack2;
-    vector<Inst*>::iterator pstack;
+    return check_input_cone(port2, driver, marks);
+}
+
+bool Circuit::check_input_cone(Port* port2, Port* driver, TraversalMarks& cone_marks) const
+{
+    vector<Inst*> stack;
     Inst *inst3, *inst2;
     Port *port3, *port1;
     Wire *wire2;
@@ -653,12 +1506,10 @@ bool Circuit::check_input_cone(Port* port2, Port* driver)
         return false;
     }
 
+    cone_marks.start(netlist);
     inst2 = driver->get_inst();
-    if (!(inst2->is_visited())) {
-        stack.push_back(inst2);
-        stack2.push_back(inst2);
-        inst2->set_visited(true);
-    }
+    cone_marks.mark(inst2);
+    stack.push_back(inst2);
 
     while (!stack.empty())
     {
@@ -692,10 +1543,8 @@ bool Circuit::check_input_cone(Port* port2, Port* driver)
                 }
                 port1 = wire2->get_driver();
                 inst2 = port1->get_inst();
-                if (!(inst2->is_visited())) {
-                    inst2->set_visited(true);
+                if (cone_marks.visit(inst2)) {
                     stack.push_back(inst2);
-                    stack2.push_back(inst2);
                 }
             }
         }
@@ -703,11 +1552,6 @@ bool Circuit::check_input_cone(Port* port2, Port* driver)
             break;
         }
     }
-    // clear visited flags
-    for (pstack= stack2.begin(); pstack != stack2.end(); pstack++) {
-        (*pstack)->set_visited(false);
-    }
-
     return found;
 }
     
@@ -754,45 +1598,205 @@ void Circuit::simulate(vector<vector<unsigned long long> >& input_vectors,
     }
     sim_patterns += num_sims;
 
-    for (int index = 0; index < int(input_vectors[0].size()); ++index) {
+    int lanes = sim_program.get_lanes();
+    int num_words = input_vectors[0].size();
+    if (num_words == 0) {
+        return;
+    }
+
+    // make room so that each task writes its own slice of signatures
+    int sig_base = signatures.get_num_words();
+    assign_signature_rows(num_words);
+    signatures.resize_words(sig_base + num_words);
+    last_sig_word.resize(sim_program.num_slots());
+
+    // split the passes ('lanes' words each) evenly across the tasks
+    int num_passes = (num_words - 1) / lanes + 1;
+    ThreadPool& pool = ThreadPool::instance();
+    int num_tasks = std::min(pool.get_num_threads(), num_passes);
+    pool.run(num_tasks, boost::bind(&Circuit::simulate_task, this, _1,
+                num_tasks, &input_vectors, num_sims, sig_base));
+
+    // wires hold the values of the last simulation word
+    for (unsigned int i = 1; i < sim_program.num_slots(); ++i) {
+        sim_program.get_wire(i)->set_sig_temp(last_sig_word[i]);
+    }
+    for (int i = 0; i < num_words; ++i) {
+        int word_sims = num_sims - i * SIGSTEP;
+        sig_word_sims.push_back((word_sims < int(SIGSTEP)) ? word_sims : SIGSTEP);
+    }
+}
+
+void Circuit::resimulate_from(Wire* wire)
+{
+    if (sig_retention != RETAIN_ALL) {
+        throw Error("Resimulation requires the signatures of all wires");
+    }
+    int lanes = sim_program.get_lanes();
+    int sig_words = signatures.get_num_words();
+    unsigned int slot = wire->get_slot();
+    unsigned long long value = wire->get_sig_temp();
+    if (resim_values.size() != sim_program.num_slots() * lanes) {
+        resim_values.assign(sim_program.num_slots() * lanes);
+    }
+    vector<Wire*> changed_wires;
+
+    for (int word = 0; word < sig_words; word += lanes) {
+        int num_words = std::min(lanes, sig_words - word);
+
+        // the source takes its new value in every word
+        bool changed = false;
+        unsigned long long* sigs = signatures.row(slot_sig_rows[slot]) + word;
+        for (int l = 0; l < num_words; ++l) {
+            if (sigs[l] != value) {
+                sigs[l] = value;
+                changed = true;
+            }
+        }
+        if (!changed) {
+            continue;
+        }
+
+        int lane_sims[SimProgram::MAX_LANES];
+        for (int l = 0; l < lanes; ++l) {
+            lane_sims[l] = (l < num_words) ? sig_word_sims[word + l] : 0;
+        }
+        schedule_fanouts(slot);
+
+        // evaluate scheduled operations level by level; an operation
+        // only schedules its readers if its output changed
+        for (int level = 0; level < int(resim_levels.size()); ++level) {
+            for (unsigned int k = 0; k < resim_levels[level].size(); ++k) {
+                unsigned int id = resim_levels[level][k];
+                resim_scheduled[id] = false;
+                const SimOp& op = sim_program.get_op(id);
+
+                const unsigned int* in = sim_program.op_fanins(op);
+                for (unsigned int j = 0; j < op.num_inputs; ++j) {
+                    load_signature_words(in[j], word, num_words);
+                }
+                sim_program.run(resim_values.get(), lane_sims, id, id + 1);
+
+                Wire* owire = sim_program.get_wire(op.out);
+                const unsigned long long* ovalues = resim_values.get() + op.out * lanes;
+                unsigned long long* osigs = signatures.row(slot_sig_rows[op.out]) + word;
+                changed = false;
+                for (int l = 0; l < num_words; ++l) {
+                    if (osigs[l] != ovalues[l]) {
+                        osigs[l] = ovalues[l];
+                        changed = true;
+                    }
+                }
+                if (changed) {
+                    schedule_fanouts(op.out);
+                    changed_wires.push_back(owire);
+                }
+            }
+            resim_levels[level].clear();
+        }
+    }
+
+    // wires hold the values of the last simulation word
+    for (int i = 0; i < int(changed_wires.size()); ++i) {
+        changed_wires[i]->set_sig_temp(changed_wires[i]->get_signature(sig_words - 1));
+    }
+}
+
+void Circuit::schedule_fanouts(unsigned int slot)
+{
+    for (const unsigned int* iter = sim_program.fanout_begin(slot);
+            iter != sim_program.fanout_end(slot); ++iter) {
+        if (!resim_scheduled[*iter]) {
+            resim_scheduled[*iter] = true;
+            resim_levels[sim_program.get_op_level(*iter)].push_back(*iter);
+        }
+    }
+}
+
+void Circuit::load_signature_words(unsigned int slot, int word, int num_words)
+{
+    if (slot == 0) {
+        return;
+    }
+    int lanes = sim_program.get_lanes();
+    const unsigned long long* sigs = signatures.row(slot_sig_rows[slot]) + word;
+    unsigned long long* wvalues = resim_values.get() + slot * lanes;
+    for (int l = 0; l < lanes; ++l) {
+        wvalues[l] = (l < num_words) ? sigs[l] : 0;
+    }
+}
+
+void Circuit::simulate_task(int task, int num_tasks,
+        vector<vector<unsigned long long> >* input_vectors, int num_sims, int sig_base)
+{
+    int lanes = sim_program.get_lanes();
+    int num_words = (*input_vectors)[0].size();
+    int num_passes = (num_words - 1) / lanes + 1;
+    int pass_begin = int((long long)(num_passes) * task / num_tasks);
+    int pass_end = int((long long)(num_passes) * (task + 1) / num_tasks);
+
+    // sources other than the primary inputs (keys) keep their wire value
+    SimValues local_values;
+    SimValues& values = (num_tasks == 1) ? sim_values : local_values;
+    load_sim_values(values);
+
+    // each pass simulates 'lanes' words of SIGSTEP patterns
+    for (int pass = pass_begin; pass < pass_end; ++pass) {
+        int index = pass * lanes;
         for (int i = 0; i < int(input_wires.size()); ++i) {
-            input_wires[i]->set_sig_temp(input_vectors[i][index]); 
+            unsigned long long* ivalues = values.get() + input_wires[i]->get_slot() * lanes;
+            for (int l = 0; l < lanes; ++l) {
+                ivalues[l] = (index + l < num_words) ? (*input_vectors)[i][index + l] : 0;
+            }
         } 
 
-        for (int i = 0; i < int(linsts.size()); ++i) {
-            if (num_sims < int(SIGSTEP)) {
-                linsts[i]->evaluate(num_sims);
-            } else {
-                linsts[i]->evaluate(SIGSTEP);
+        int pass_sims = num_sims - index * SIGSTEP;
+        if (pass_sims < lanes * int(SIGSTEP)) {
+            sim_program.run(values.get(), pass_sims);
+        } else {
+            sim_program.run(values.get(), lanes * SIGSTEP);
+        }
+        int pass_words = std::min(lanes, num_words - index);
+        commit_signatures(values, sig_base + index, pass_words);
+
+        if (index + pass_words == num_words) {
+            for (unsigned int i = 1; i < sim_program.num_slots(); ++i) {
+                last_sig_word[i] = values[i * lanes + pass_words - 1];
             }
-        } 
-        num_sims -= SIGSTEP;
-        commit_signatures();
+        }
     }
 }
 
-void Circuit::print_testability()
+void Circuit::print_testability(const vector<Inst*>& skipped)
 {
+    marks.start(netlist);
+    for (int i = 0; i < int(skipped.size()); ++i) {
+        marks.mark(skipped[i]);
+    }
+
     simulate_test();
-    int num_sites = 0;
-    int num_found = 0;
+    vector<Fault> faults;
     for (int i = 0; i < linsts.size(); ++i) {
         Wire* owire = linsts[i]->get_output(0)->get_wire();
         if (owire->is_output()) {
             continue;
         } 
-        if (linsts[i]->is_visited()) {
+        if (marks.is_marked(linsts[i])) {
             continue;
         }
 
-        num_sites += 2;
-        if (observable_signal(linsts[i], STUCK1)) {
-            ++num_found;
-        }
-        if (observable_signal(linsts[i], STUCK0)) {
+        faults.push_back(Fault(linsts[i], STUCK1));
+        faults.push_back(Fault(linsts[i], STUCK0));
+    } 
+    simulate_faults(faults);
+
+    int num_sites = faults.size();
+    int num_found = 0;
+    for (int i = 0; i < int(faults.size()); ++i) {
+        if (faults[i].detected) {
             ++num_found;
         }
-    } 
+    }
     
     cout << "Testability of candidate gates: " << 
         double(num_found) / double(num_sites) * 100 << "; Num remaining: " 
@@ -800,54 +1804,122 @@ void Circuit::print_testability()
 }
 
 
-// true if current input signatures reveal that the given signal is observable
+void Circuit::simulate_faults(vector<Fault>& faults)
+{
+    vector<vector<Fault> > round_faults(1);
+    round_faults[0].swap(faults);
+    vector<SimValues> round_sources(1);
+    load_sim_values(round_sources[0]);
+
+    simulate_faults(round_faults, round_sources);
+    faults.swap(round_faults[0]);
+}
+
+void Circuit::simulate_faults(vector<vector<Fault> >& round_faults,
+        const vector<SimValues>& round_sources)
+{
+    assert(round_faults.size() == round_sources.size());
+    int num_rounds = round_faults.size();
+    if (num_rounds == 0) {
+        return;
+    }
+
+    // each task takes one part of the fault list of one round
+    ThreadPool& pool = ThreadPool::instance();
+    int num_parts = (pool.get_num_threads() - 1) / num_rounds + 1;
+    pool.run(num_rounds * num_parts, boost::bind(&Circuit::simulate_faults_task,
+                this, _1, num_parts, &round_faults, &round_sources));
+}
+
+void Circuit::simulate_faults_task(int task, int num_parts,
+        vector<vector<Fault> >* round_faults, const vector<SimValues>* round_sources)
+{
+    int round = task / num_parts;
+    int part = task % num_parts;
+    vector<Fault>& faults = (*round_faults)[round];
+    int begin = int((long long)(faults.size()) * part / num_parts);
+    int end = int((long long)(faults.size()) * (part + 1) / num_parts);
+    if (begin == end) {
+        return;
+    }
+
+    vector<unsigned int> input_slots;
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        input_slots.push_back(input_wires[i]->get_slot());
+    }
+    vector<unsigned int> output_slots;
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        output_slots.push_back(output_wires[i]->get_slot());
+    }
+
+    // every task has its own simulator and its own copy of the faults
+    vector<Fault> part_faults(faults.begin() + begin, faults.begin() + end);
+    FaultSim fault_sim(sim_program, output_slots, input_slots, input_vecs, num_test_vec);
+    fault_sim.run(part_faults, (*round_sources)[round]);
+    std::copy(part_faults.begin(), part_faults.end(), faults.begin() + begin);
+}
+
 bool Circuit::observable_cover(string inst_name, string wire_name, CoverType cover)
 {
-    Inst* inst = (Inst*) sym_table[inst_name];
-    Wire* wire = (Wire*) sym_table[wire_name];
+    return observable_cover(find_inst(inst_name), find_wire(wire_name), cover);
+}
+
+// true if current input signatures reveal that the given signal is observable
+bool Circuit::observable_cover(Inst* inst, Wire* wire, CoverType cover) const
+{
     assert(sim_patterns > 0);
 
     Wire* owire = inst->get_output(0)->get_wire();
     int num_patterns = (sim_patterns - 1)/ SIGSTEP + 1;
-    int leftover = sim_patterns%SIGSTEP;
-        
-    for (int j = 0; j < num_patterns; ++j) {
-        for (int i = 0; i < int(input_wires.size()); ++i) {
-            input_wires[i]->set_sig_temp(input_wires[i]->get_signature(j));
-        }
 
-        for (int i = 0; i < int(linsts.size()); ++i) {
-            if ((j == (num_patterns - 1)) && (leftover > 0)) {
-                linsts[i]->evaluate(leftover);
+    // the cover replaces the instance output right after it is evaluated
+    unsigned int split = sim_program.inst_end(inst);
+    unsigned int oslot = owire->get_slot();
+    unsigned int cslot = wire->get_slot();
+    int lanes = sim_program.get_lanes();
+    SimValues values;
+    load_sim_values(values);
+    unsigned long long* ovalues = values.get() + oslot * lanes;
+    unsigned long long* cvalues = values.get() + cslot * lanes;
+        
+    for (int j = 0; j < num_patterns; j += lanes) {
+        load_signature_inputs(values, j, num_patterns);
+
+        int num_sims = sim_patterns - j * SIGSTEP;
+        sim_program.run(values.get(), num_sims, 0, split);
+        for (int l = 0; (split > 0) && (l < lanes); ++l) {
+            if (cover == EQUAL) {
+                ovalues[l] = cvalues[l];
+            } else if (cover == AND) {
+                ovalues[l] = cvalues[l] & ovalues[l];
+            } else if (cover == OR) {
+                ovalues[l] = cvalues[l] | ovalues[l];
             } else {
-                linsts[i]->evaluate(SIGSTEP);
+                assert(0);
             }
+        }
+        sim_program.run(values.get(), num_sims, split, sim_program.num_ops());
 
-            if (linsts[i] == inst) {
-                if (cover == EQUAL) {
-                    owire->set_sig_temp((wire->get_sig_temp()));
-                } else if (cover == AND) {
-                    owire->set_sig_temp((wire->get_sig_temp() & owire->get_sig_temp()));
-                } else if (cover == OR) {
-                    owire->set_sig_temp((wire->get_sig_temp() | owire->get_sig_temp()));
-                } else {
-                    assert(0);
-                }
-            }
-        } 
-
-        for (int i = 0; i < int(output_wires.size()); ++i) {
-            if (output_wires[i]->get_sig_temp() != output_wires[i]->get_signature(j)) {
-                return true;
-            }
+        if (outputs_differ(values, j, num_patterns)) {
+            return true;
         }
     }
 
     return false;
 }
 
+void Circuit::observable_covers(vector<CoverCheck>& checks) const
+{
+    // one task per check: the checks take about the same time
+    ThreadPool::instance().run(checks.size(),
+            boost::bind(&Circuit::observable_cover_task, this, _1, &checks));
+}
 
-
+void Circuit::observable_cover_task(int task, vector<CoverCheck>* checks) const
+{
+    CoverCheck& check = (*checks)[task];
+    check.observable = observable_cover(check.inst, check.wire, check.cover);
+}
 
 // true if current input signatures reveal that the given signal is observable
 bool Circuit::observable_signal(Inst* inst, ModType mod)
@@ -856,43 +1928,101 @@ bool Circuit::observable_signal(Inst* inst, ModType mod)
 
     Wire* owire = inst->get_output(0)->get_wire();
     int num_patterns = (sim_patterns - 1)/ SIGSTEP + 1;
-    int leftover = sim_patterns%SIGSTEP;
-        
-    for (int j = 0; j < num_patterns; ++j) {
-        for (int i = 0; i < int(input_wires.size()); ++i) {
-            input_wires[i]->set_sig_temp(input_wires[i]->get_signature(j));
-        }
 
-        for (int i = 0; i < int(linsts.size()); ++i) {
-            if ((j == (num_patterns - 1)) && (leftover > 0)) {
-                linsts[i]->evaluate(leftover);
+    // the modification is applied right after the instance is evaluated
+    unsigned int split = sim_program.inst_end(inst);
+    unsigned int oslot = owire->get_slot();
+    int lanes = sim_program.get_lanes();
+    SimValues values;
+    load_sim_values(values);
+    unsigned long long* ovalues = values.get() + oslot * lanes;
+        
+    for (int j = 0; j < num_patterns; j += lanes) {
+        load_signature_inputs(values, j, num_patterns);
+
+        int num_sims = sim_patterns - j * SIGSTEP;
+        sim_program.run(values.get(), num_sims, 0, split);
+        for (int l = 0; (split > 0) && (l < lanes); ++l) {
+            if (mod == FLIP) {
+                ovalues[l] = ~(ovalues[l]);
+            } else if (mod == STUCK0) {
+                ovalues[l] = 0;
+            } else if (mod == STUCK1) {
+                ovalues[l] = ~((unsigned long long)(0));
             } else {
-                linsts[i]->evaluate(SIGSTEP);
-            }
-
-            if (linsts[i] == inst) {
-                if (mod == FLIP) {
-                    owire->set_sig_temp(~(owire->get_sig_temp()));
-                } else if (mod == STUCK0) {
-                    owire->set_sig_temp(0);
-                } else if (mod == STUCK1) {
-                    owire->set_sig_temp(~((unsigned long long)(0)));
-                } else {
-                    assert(0);
-                }
+                assert(0);
             }
-        } 
+        }
+        sim_program.run(values.get(), num_sims, split, sim_program.num_ops());
 
-        for (int i = 0; i < int(output_wires.size()); ++i) {
-            if (output_wires[i]->get_sig_temp() != output_wires[i]->get_signature(j)) {
-                return true;
-            }
+        if (outputs_differ(values, j, num_patterns)) {
+            return true;
         }
     }
 
     return false;
 }
 
+void Circuit::observability_masks(SignatureMatrix& masks)
+{
+    assert(sim_patterns > 0);
+    int num_words = (sim_patterns - 1) / SIGSTEP + 1;
+    masks.reset(linsts.size(), num_words);
+    for (int i = 0; i < int(linsts.size()); ++i) {
+        masks.add_row();
+    }
+    masks.resize_words(num_words);
+
+    // the input signatures are the vectors of the simulator
+    vector<vector<unsigned long long> > input_vectors(input_wires.size());
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        for (int j = 0; j < num_words; ++j) {
+            input_vectors[i].push_back(input_wires[i]->get_signature(j));
+        }
+    }
+    SimValues source_values;
+    load_sim_values(source_values);
+
+    // split the passes ('lanes' words each) evenly across the tasks
+    int num_passes = (num_words - 1) / sim_program.get_lanes() + 1;
+    ThreadPool& pool = ThreadPool::instance();
+    int num_tasks = std::min(pool.get_num_threads(), num_passes);
+    pool.run(num_tasks, boost::bind(&Circuit::observability_task, this, _1,
+                num_tasks, &input_vectors, &source_values, &masks));
+}
+
+void Circuit::observability_task(int task, int num_tasks,
+        const vector<vector<unsigned long long> >* input_vectors,
+        const SimValues* source_values, SignatureMatrix* masks)
+{
+    int lanes = sim_program.get_lanes();
+    int num_words = masks->get_num_words();
+    int num_passes = (num_words - 1) / lanes + 1;
+    int begin = num_passes * task / num_tasks;
+    int end = num_passes * (task + 1) / num_tasks;
+
+    vector<unsigned int> input_slots;
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        input_slots.push_back(input_wires[i]->get_slot());
+    }
+    vector<unsigned int> output_slots;
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        output_slots.push_back(output_wires[i]->get_slot());
+    }
+
+    FaultSim fault_sim(sim_program, output_slots, input_slots, *input_vectors, sim_patterns);
+    for (int pass = begin; pass < end; ++pass) {
+        int word = pass * lanes;
+        int pass_words = std::min(lanes, num_words - word);
+        fault_sim.load_observability(*source_values, word);
+        for (int i = 0; i < int(linsts.size()); ++i) {
+            unsigned int slot = linsts[i]->get_output(0)->get_wire()->get_slot();
+            const unsigned long long* obs = fault_sim.get_observability(slot);
+            std::copy(obs, obs + pass_words, masks->row(i) + word);
+        }
+    }
+}
+
 // primary inputs are indicated in the first line
 // the remaining lines contain 0s and 1s
 void Circuit::load_test_vectors(string testfile)
@@ -901,101 +2031,121 @@ void Circuit::load_test_vectors(string testfile)
     if (!fin) {
         throw Error("Cannot open test file");
     }
-    
+    fin.close();
+
+    vector<string> input_names;
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        input_names.push_back(input_wires[i]->get_name());
+    }
     input_vecs.resize(input_wires.size());
-    vector<int> testpos2wire_index;
 
-    string pi_input;
-    while (fin >> pi_input) {
-        bool found = false;
-        for (int i = 0; i < int(input_wires.size()); ++i) {
-            if (input_wires[i]->get_name() == pi_input) {
-                testpos2wire_index.push_back(i);
-                found = true;
-            }
-        }
-        if (!found) {
-            throw Error("Could not find test input: " + pi_input + " in circuit" );
-        }
+    PatternReader reader(testfile);
+    num_test_vec = reader.read(input_names, input_vecs);
+    cout << "Num input patterns: " << num_test_vec << endl;
+}
 
-        if (testpos2wire_index.size() == input_wires.size()) {
-            break;
-        }
+void Circuit::write_test_vectors(string patternfile)
+{
+    vector<string> input_names;
+    for (int i = 0; i < int(input_wires.size()); ++i) {
+        input_names.push_back(input_wires[i]->get_name());
     }
-    if (testpos2wire_index.size() != input_wires.size()) {
-        throw Error("Test file is missing circuit inputs");
+    write_pattern_file(patternfile, input_names, input_vecs, num_test_vec);
+}
+
+void Circuit::clear_signatures()
+{
+    signatures.resize_words(0);
+    sim_patterns = 0;
+    sig_word_sims.clear();
+}
+
+void Circuit::set_signature_retention(SignatureRetention retention,
+        const vector<string>& names)
+{
+    sig_retention = retention;
+    sig_retained_names.clear();
+    if (retention == RETAIN_NAMED) {
+        sig_retained_names.insert(names.begin(), names.end());
     }
+    clear_signatures();
+}
 
-    num_test_vec = 1;
-    int input_spot = 0;
-    char val;
-    while (fin >> val) {
-        if (val == '\n') {
-            continue;
-        }
+void Circuit::assign_signature_rows(int num_words)
+{
+    unordered_set<Wire*> ports;
+    if (sig_retention != RETAIN_ALL) {
+        ports.insert(input_wires.begin(), input_wires.end());
+        ports.insert(output_wires.begin(), output_wires.end());
+    }
 
-        if (input_spot == int(testpos2wire_index.size())) {
-            input_spot = 0;
-            ++num_test_vec;
+    // rows are laid out again once the saved signatures are cleared
+    bool fresh = (signatures.get_num_words() == 0);
+    if (fresh) {
+        int num_rows = sim_program.num_slots() - 1;
+        if (sig_retention != RETAIN_ALL) {
+            num_rows = ports.size() + sig_retained_names.size();
         }
+        signatures.reset(num_rows, num_words);
+    }
 
-        int sim_val;
-        if (val == '0') {
-            sim_val = 0;
-        } else if (val == '1') {
-            sim_val = 1;
-        } else {
-            throw Error("Unrecognized value in test file");
-        }
-       
-        int pos = testpos2wire_index[input_spot];
-        int index = (num_test_vec - 1)/ SIGSTEP;
-        int leftover = (num_test_vec-1)%SIGSTEP;
-        
-        if (int(input_vecs[pos].size()) == index) {
-            input_vecs[pos].push_back(0);
+    slot_sig_rows.assign(sim_program.num_slots(), -1);
+    for (unsigned int i = 1; i < sim_program.num_slots(); ++i) {
+        Wire* wire = sim_program.get_wire(i);
+        bool retained = (sig_retention == RETAIN_ALL) || (ports.find(wire) != ports.end()) ||
+            (sig_retained_names.find(wire->get_name()) != sig_retained_names.end());
+        int row = -1;
+        if (retained) {
+            row = fresh ? -1 : wire->get_signature_row();
+            if (row == -1) {
+                row = signatures.add_row();
+            }
         }
-
-        input_vecs[pos][index] |= (((unsigned long long) sim_val) << leftover);
-        ++input_spot;        
+        wire->set_signature_row(&signatures, row);
+        slot_sig_rows[i] = row;
     }
-
-    fin.close();
-    cout << "Num input patterns: " << num_test_vec << endl;
 }
 
-void Circuit::clear_signatures()
+// saves num_words simulation words as signature words [word, word + num_words)
+// for every retained wire
+void Circuit::commit_signatures(const SimValues& values, int word, int num_words)
 {
-    for (sym_map::iterator iter = sym_table.begin();
-            iter != sym_table.end(); ++iter) {
-        if (iter->second->get_type() == WIRE) {
-            Wire* wire = (Wire*)(iter->second);
-            wire->clear_signature();
+    int lanes = sim_program.get_lanes();
+    for (unsigned int i = 1; i < sim_program.num_slots(); ++i) {
+        if (slot_sig_rows[i] < 0) {
+            continue;
         }
+        memcpy(signatures.row(slot_sig_rows[i]) + word, values.get() + i * lanes,
+                num_words * sizeof(unsigned long long));
     }
-    sim_patterns = 0;
 }
 
-void Circuit::commit_signatures()
+void Circuit::output_differences(Circuit* ckt1, int& num_out_mismatch, int& num_vec_mismatch)
 {
-    for (sym_map::iterator iter = sym_table.begin();
-            iter != sym_table.end(); ++iter) {
-        if (iter->second->get_type() == WIRE) {
-            Wire* wire = (Wire*)(iter->second);
-            wire->commit_signature();
+    num_out_mismatch = 0;
+    num_vec_mismatch = 0;
+
+    assert(output_wires.size() == ckt1->output_wires.size());
+    
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        int diffs = output_wires[i]->sig_diffs(*(ckt1->output_wires[i]));
+        if (diffs > 0) {
+            ++num_out_mismatch;
         }
+        num_vec_mismatch += diffs;
     }
 }
 
-void Circuit::output_differences(Circuit* ckt1, int& num_out_mismatch, int& num_vec_mismatch)
+void Circuit::output_differences(const ResponseMatrix& responses,
+        int& num_out_mismatch, int& num_vec_mismatch)
 {
     num_out_mismatch = 0;
     num_vec_mismatch = 0;
 
-    assert(output_wires.size() == ckt1->output_wires.size());
+    assert(output_wires.size() == responses.size());
     
     for (int i = 0; i < int(output_wires.size()); ++i) {
-        int diffs = output_wires[i]->sig_diffs(*(ckt1->output_wires[i]));
+        int diffs = output_wires[i]->sig_diffs(responses[i]);
         if (diffs > 0) {
             ++num_out_mismatch;
         }
@@ -1003,6 +2153,115 @@ void Circuit::output_differences(Circuit* ckt1, int& num_out_mismatch, int& num_
     }
 }
 
+void Circuit::get_output_responses(ResponseMatrix& responses)
+{
+    responses.clear();
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        responses.push_back(output_wires[i]->get_signature());
+    }
+}
+
+unsigned long long Circuit::test_vector_checksum()
+{
+    unsigned long long checksum = 14695981039346656037ULL;
+    for (int i = 0; i < int(input_vecs.size()); ++i) {
+        for (int j = 0; j < int(input_vecs[i].size()); ++j) {
+            checksum = (checksum ^ input_vecs[i][j]) * 1099511628211ULL;
+        }
+    }
+    return checksum;
+}
+
+//! marks the byte order of the packed words of a response file
+static const unsigned long long RESPONSE_BYTE_ORDER = 0x0102030405060708ULL;
+
+bool Circuit::read_test_responses(string respfile, ResponseMatrix& responses)
+{
+    if (!ifstream(respfile.c_str())) {
+        return false;
+    }
+    MappedFile file(respfile);
+
+    // the two header lines
+    const char* end = file.end();
+    const char* pos = std::find(file.begin(), end, '\n');
+    if (pos != end) {
+        pos = std::find(pos + 1, end, '\n');
+    }
+    if (pos == end) {
+        return false;
+    }
+    ++pos;
+    std::istringstream header(string(file.begin(), pos));
+
+    // responses of another netlist or other vectors are not reused
+    int num_vec;
+    unsigned long long checksum;
+    unsigned long long netlist;
+    if (!(header >> num_vec >> checksum >> netlist) || (num_vec != num_test_vec) ||
+            (checksum != test_vector_checksum()) ||
+            (netlist != (unsigned long long)(sim_program.netlist_hash()))) {
+        return false;
+    }
+
+    string po_output;
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        if (!(header >> po_output) || (po_output != output_wires[i]->get_name())) {
+            return false;
+        }
+    }
+
+    // files from another host or in an older format are written again
+    std::size_t num_words = (num_test_vec - 1) / SIGSTEP + 1;
+    std::size_t words_size = output_wires.size() * num_words * sizeof(unsigned long long);
+    unsigned long long byte_order;
+    if (std::size_t(end - pos) != sizeof(byte_order) + words_size) {
+        return false;
+    }
+    memcpy(&byte_order, pos, sizeof(byte_order));
+    if (byte_order != RESPONSE_BYTE_ORDER) {
+        return false;
+    }
+    pos += sizeof(byte_order);
+
+    responses.assign(output_wires.size(), vector<unsigned long long>(num_words, 0));
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        memcpy(&responses[i][0], pos, num_words * sizeof(unsigned long long));
+        pos += num_words * sizeof(unsigned long long);
+    }
+
+    cout << "Num saved responses: " << num_test_vec << endl;
+    return true;
+}
+
+void Circuit::write_test_responses(string respfile, const ResponseMatrix& responses)
+{
+    assert(responses.size() == output_wires.size());
+    ofstream fout(respfile.c_str(), std::ios::binary);
+    if (!fout) {
+        throw Error("Cannot write response file");
+    }
+
+    fout << num_test_vec << " " << test_vector_checksum() << " "
+        << (unsigned long long)(sim_program.netlist_hash()) << "\n";
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        fout << output_wires[i]->get_name() << " ";
+    }
+    fout << "\n";
+
+    std::size_t num_words = (num_test_vec - 1) / SIGSTEP + 1;
+    fout.write((const char*)(&RESPONSE_BYTE_ORDER), sizeof(RESPONSE_BYTE_ORDER));
+    for (int i = 0; i < int(output_wires.size()); ++i) {
+        vector<unsigned long long> words(responses[i]);
+        words.resize(num_words, 0);
+        fout.write((const char*)(&words[0]), num_words * sizeof(unsigned long long));
+    }
+    fout.close();
+    if (!fout) {
+        throw Error("Cannot write response file");
+    }
+}
+
 bool Circuit::circuit_sig_equiv(Circuit* ckt1)
 {
     assert(output_wires.size() == ckt1->output_wires.size());
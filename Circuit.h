@@ -6,7 +6,13 @@
 #include <vector>
 #include <iosfwd>
 #include <fstream>
+#include <boost/utility/string_ref.hpp>
 #include "Wire.h"
+#include "SimProgram.h"
+#include "SignatureMatrix.h"
+#include "BlifReader.h"
+#include "Netlist.h"
+#include "TraversalMarks.h"
 
 class CircuitElement;
 class Inst;
@@ -15,12 +21,71 @@ class TechLibrary;
 
 enum ModType { FLIP, STUCK0, STUCK1 };
 
+/*!
+ * Wires whose signatures are saved by simulation.  Primary inputs and
+ * outputs are always saved; RETAIN_NAMED also saves a list of wires.
+*/
+enum SignatureRetention { RETAIN_ALL, RETAIN_OUTPUTS, RETAIN_NAMED };
+
+//! modification of an instance output checked by fault simulation
+struct Fault {
+    Fault(Inst* inst_, ModType mod_) : inst(inst_), mod(mod_), detected(false) {}
+    Inst* inst;
+    ModType mod;
+    bool detected;
+};
+
+//! cover of the output of inst by wire, checked by Circuit::observable_covers
+struct CoverCheck {
+    CoverCheck(Inst* inst_, Wire* wire_, CoverType cover_) : inst(inst_), wire(wire_),
+        cover(cover_), observable(false) {}
+    Inst* inst;
+    Wire* wire;
+    CoverType cover;
+    bool observable;
+};
+
 class Circuit {
   public:
+    //! signature words of each primary output (one row per output)
+    typedef std::vector<std::vector<unsigned long long> > ResponseMatrix;
+
+    /*!
+     * Read a BLIF file, an AIGER file (.aig or .aag), an ISCAS .bench
+     * file, or a binary netlist written by write_snapshot.
+    */
     Circuit(std::string filename, TechLibrary* library_);
+
+    //! releases every element of the circuit
+    virtual ~Circuit() {}
       
     void write_blif(std::string filename);
+
+    /*!
+     * Save the levelized circuit (with any key section) as a binary
+     * netlist, see Snapshot.h.  Signatures and vectors are not saved.
+    */
+    void write_snapshot(std::string filename);
+
+    /*!
+     * Write the COMBINATIONAL circuit as a binary AIGER file (latch
+     * outputs and inputs become primary inputs and outputs).  Key
+     * inputs are listed after the primary inputs and named in the
+     * comment section.
+    */
+    void write_aiger(std::string filename);
+
+    /*!
+     * True if port2 is in the input cone of driver.  Uses the marks of
+     * the circuit (one query at a time).
+    */
     bool check_input_cone(Port* port2, Port* driver);
+
+    /*!
+     * Same as check_input_cone(port2, driver) with the caller's marks;
+     * queries with their own marks can run at the same time.
+    */
+    bool check_input_cone(Port* port2, Port* driver, TraversalMarks& cone_marks) const;
    
     typedef std::vector<Inst*>::iterator inst_iterator;
     inst_iterator inst_begin()
@@ -64,7 +129,23 @@ class Circuit {
     virtual bool circuit_sig_equiv(Circuit* ckt1);
 
     void clear_signatures();
-    void commit_signatures();
+
+    /*!
+     * Choose the wires whose signatures are saved (names are used with
+     * RETAIN_NAMED).  Saved signatures are cleared.  Wires that are not
+     * retained still hold the value of the last simulation word.
+    */
+    void set_signature_retention(SignatureRetention retention,
+            const std::vector<std::string>& names = std::vector<std::string>());
+
+    /*!
+     * Update the saved signatures after the value (sig_temp) of a
+     * source wire such as a key input changed.  Only the gates in the
+     * fanout of the wire are evaluated and propagation stops at gates
+     * whose output does not change.  The result matches simulating
+     * the saved vectors again.  Requires RETAIN_ALL.
+    */
+    void resimulate_from(Wire* wire);
 
     int get_num_test_vectors() const
     {
@@ -74,21 +155,95 @@ class Circuit {
     /*!
      * Takes a series of test vectors (1st line is a list of PI
      * names and the remaining lines are 0's and 1's with no spaces)
+     * or a packed pattern file written by write_test_vectors
     */
     void load_test_vectors(std::string testfile);
+
+    //! write the loaded test vectors as a packed pattern file
+    void write_test_vectors(std::string patternfile);
     void print_info();
 
     void output_differences(Circuit* ckt1, int& num_out_mismatch, int& num_vec_mismatch);
 
+    /*!
+     * Compares the output signatures to saved responses of another
+     * circuit (from get_output_responses) for the same vectors.
+    */
+    void output_differences(const ResponseMatrix& responses,
+            int& num_out_mismatch, int& num_vec_mismatch);
+
+    void get_output_responses(ResponseMatrix& responses);
+
+    /*!
+     * Read output responses to the loaded test vectors that were saved
+     * by write_test_responses.  Returns false if the file cannot be
+     * opened, was written for a different netlist, outputs or test
+     * vectors, or was written on a host with another byte order or in
+     * the old text format.
+    */
+    bool read_test_responses(std::string respfile, ResponseMatrix& responses);
+
+    /*!
+     * Save output responses to the loaded test vectors.  The first line
+     * lists the number of vectors, a checksum of the vectors and a hash
+     * of the netlist (SimProgram::netlist_hash), the second line the
+     * output names.  A 64-bit byte order mark and the packed response
+     * words of each output (bit i of word j is vector
+     * 64 * j + i) follow in binary.
+    */
+    void write_test_responses(std::string respfile, const ResponseMatrix& responses);
+
     bool observable_signal(Inst* inst, ModType mod = FLIP);
-    void print_testability();
+
+    /*!
+     * Observability of every gate for the current input signatures
+     * from one backward pass (see FaultSim::load_observability): row i
+     * of masks holds the patterns where flipping the output of
+     * linsts[i] changes an output, so a row is non-zero exactly when
+     * observable_signal with FLIP is true.  Words are split across the
+     * thread pool.
+    */
+    void observability_masks(SignatureMatrix& masks);
+
+    /*!
+     * Fault simulation of the test vectors.  Sets detected for each
+     * fault that is observable (same result as observable_signal
+     * after simulate_test).
+    */
+    void simulate_faults(std::vector<Fault>& faults);
+
+    /*!
+     * Fault simulation of the test vectors for several assignments of
+     * the non-input sources (from load_sim_values).  round_faults[i] is
+     * simulated with round_sources[i].  Rounds and faults are split
+     * across the thread pool.
+    */
+    void simulate_faults(std::vector<std::vector<Fault> >& round_faults,
+            const std::vector<SimValues>& round_sources);
+
+    /*!
+     * Print the stuck-at fault coverage of the test vectors.  Faults on
+     * the skipped instances are not counted.
+    */
+    void print_testability(const std::vector<Inst*>& skipped = std::vector<Inst*>());
 
     /*!
      * Levelization requires that the input_wires vector
-     * be initialized.
+     * be initialized.  Instances are ordered as if the gates were
+     * placed in repeated passes over lib_insts (each pass adds, in
+     * order, every gate whose inputs are ready), but in linear time.
+     * Throws an Error naming the loop or the undriven wire if some
+     * gates cannot be placed.
     */
     virtual void levelize();
 
+    /*!
+     * Same result as levelize() after gates were added to lib_insts
+     * (and wires reconnected to them), but only the fanout cone of the
+     * new gates is levelized again.
+    */
+    void levelize_new_insts();
+
     std::vector<std::vector<unsigned long long> > get_random_inputs()
     {
         return rand_input_vecs; 
@@ -103,14 +258,46 @@ class Circuit {
     void load_test_vectors(const char* testfile);
     
     bool wires_equal(std::string w1, std::string w2, CoverType type);
+    bool wires_equal(Wire* wire1, Wire* wire2, CoverType type);
     bool observable_cover(std::string inst_name, std::string wire_name, CoverType cover);
 
+    /*!
+     * True if current input signatures reveal that covering the output
+     * of inst with wire is observable.
+    */
+    bool observable_cover(Inst* inst, Wire* wire, CoverType cover) const;
+
+    /*!
+     * Set observable for each check as observable_cover does, running
+     * the checks across the thread pool (the circuit is only read).
+    */
+    void observable_covers(std::vector<CoverCheck>& checks) const;
+
+    //! element with the given name (0 if there is none)
+    CircuitElement* find_element(boost::string_ref name);
+    Wire* find_wire(boost::string_ref name);
+    Inst* find_inst(boost::string_ref name);
+
+    /*!
+     * Map the elements of another circuit to the elements of this
+     * circuit with the same name: wires[id] and insts[id] are the
+     * matches of the wire and instance with that id in other (0 where
+     * there is no match).  Names are hashed once here, so queries
+     * between the circuits can then go by id.
+    */
+    void match_elements(Circuit& other, std::vector<Wire*>& wires, std::vector<Inst*>& insts);
+
   protected:
     TechLibrary* library;
+
+    //! owns the wires, instances and ports
+    Netlist netlist;
         
-    //! maps circuit elements to unique names
-    typedef std::tr1::unordered_map<std::string, CircuitElement*> sym_map;
-    sym_map sym_table;    
+    //! element of each name id of the netlist (0 if the name is not an element)
+    std::vector<CircuitElement*> symbols;
+
+    //! make the element the symbol of its name
+    void add_symbol(CircuitElement* element);
     std::vector<Inst*> linsts;
     
     //! non input/output/latch instances
@@ -120,21 +307,153 @@ class Circuit {
     
     std::string blif_name;
 
+    //! levelized simulation view, rebuilt by levelize()
+    SimProgram sim_program;
+
+    /*!
+     * Initialize a value array with the current wire values
+     * (used for sources that are not primary inputs, e.g., keys).
+    */
+    void load_sim_values(SimValues& values) const;
+
+    //! key wires, their unlocking values and the inserted gates
+    struct KeySection {
+        std::vector<Wire*> wires;
+        std::vector<int> values;
+        std::vector<Inst*> new_gates;
+    };
+
+    //! key section of a loaded binary netlist (restored by EncryptedCircuit)
+    KeySection loaded_keys;
+
+    //! visited elements of the traversals run by the circuit itself
+    TraversalMarks marks;
+
+    //! mark the wires that levelize() starts from
+    virtual void mark_sources(TraversalMarks& source_marks);
+
+    //! key section saved by write_snapshot and write_aiger
+    virtual void get_key_section(KeySection& keys)
+    {
+        keys = loaded_keys;
+    }
+
   private:
     void simulate(std::vector<std::vector<unsigned long long> >& input_vectors,
             int num_sims);
+
+    /*!
+     * Simulates one contiguous block of the passes needed for the
+     * input vectors (work split for the thread pool).
+    */
+    void simulate_task(int task, int num_tasks,
+            std::vector<std::vector<unsigned long long> >* input_vectors,
+            int num_sims, int sig_base);
+
+    void commit_signatures(const SimValues& values, int word, int num_words);
+
+    /*!
+     * Give every retained wire in the program a signature row (rows of
+     * new wires are added if signatures are being accumulated).
+    */
+    void assign_signature_rows(int num_words);
+
+    //! identifies the loaded test vectors in a response file
+    unsigned long long test_vector_checksum();
     void parse_blif(std::string filename);
-    int get_blif_token(std::string& token);
-    int get_blif_ttable(std::string& token);
-    Wire* find_wire_insert(std::string& name);
+    void parse_aiger(std::string filename);
+    void parse_bench(std::string filename);
+
+    //! create the elements of parsed statements (tables index the cells)
+    void add_statements(const std::vector<BlifStatement>& statements,
+            const std::vector<std::pair<int, std::string> >& tables);
+
+    /*!
+     * Create the levelized circuit saved in a binary netlist.  Throws
+     * an Error if the file is not a valid binary netlist of this
+     * version.
+    */
+    void load_snapshot(std::string filename);
+    Wire* find_wire_insert(boost::string_ref name);
+
+    /*!
+     * Compile the levelized instances into sim_program.  Every wire
+     * in the circuit is given a slot.
+    */
+    void compile_sim_program();
+
+    /*!
+     * Level the gates at the given lib_insts positions, which must
+     * include every gate reading one of them, and merge them into
+     * linsts.  The other gates keep their levels.  Positions from
+     * first_new on are gates added since the last levelization (0
+     * levels everything).
+    */
+    void levelize_region(std::vector<unsigned int>& region, unsigned int first_new);
+
+    /*!
+     * lib_insts position of the gate driving an input wire, or
+     * SOURCE_INPUT (ready from the start) or UNDRIVEN_INPUT (never
+     * ready).  Sources must be marked (see mark_sources).
+    */
+    int input_driver(Wire* wire);
+
+    //! why some gates of the region could not be placed
+    std::string unplaced_error(const std::vector<unsigned int>& region,
+            const std::vector<char>& placed);
+
+    /*!
+     * Fault simulates one part of the faults of one round (work split
+     * for the thread pool).
+    */
+    void simulate_faults_task(int task, int num_parts,
+            std::vector<std::vector<Fault> >* round_faults,
+            const std::vector<SimValues>* round_sources);
+
+    //! observability of the words of one task (see observability_masks)
+    void observability_task(int task, int num_tasks,
+            const std::vector<std::vector<unsigned long long> >* input_vectors,
+            const SimValues* source_values, SignatureMatrix* masks);
+
+    //! runs check task of observable_covers
+    void observable_cover_task(int task, std::vector<CoverCheck>* checks) const;
+
+    /*!
+     * Load primary input signature words [word, word + lanes) into
+     * values (words past num_words are 0).
+    */
+    void load_signature_inputs(SimValues& values, int word, int num_words) const;
+
+    /*!
+     * True if an output value differs from its signature in one of the
+     * simulation words starting at word.
+    */
+    bool outputs_differ(SimValues& values, int word, int num_words) const;
+
+    //! queue the operations reading slot for resimulate_from()
+    void schedule_fanouts(unsigned int slot);
+
+    //! load signature words [word, word + num_words) of slot into resim_values
+    void load_signature_words(unsigned int slot, int word, int num_words);
 
     int sim_patterns;
+
+    //! saved signature words, one row per retained wire
+    SignatureMatrix signatures;
+    SignatureRetention sig_retention;
+    std::tr1::unordered_set<std::string> sig_retained_names;
+
+    //! signature row of each program slot (-1 if not retained)
+    std::vector<int> slot_sig_rows;
+
+    //! values of the last simulation word by slot (sets sig_temp)
+    std::vector<unsigned long long> last_sig_word;
+
+    //! number of valid patterns in each signature word
+    std::vector<int> sig_word_sims;
     int num_test_vec;
     int num_rand_vec;
 
-    //! blif file stream 
-    std::fstream ifile;
- 
 
     std::vector<Wire*> constants_list;
     std::tr1::unordered_set<std::string> one_list;
@@ -149,7 +468,32 @@ class Circuit {
     std::vector<std::vector<unsigned long long> > input_vecs;
     std::vector<std::vector<unsigned long long> > rand_input_vecs;
 
+    //! simulation values indexed by program slot
+    SimValues sim_values;
+
+    //! work space for resimulate_from()
+    SimValues resim_values;
+    std::vector<bool> resim_scheduled;
+    std::vector<std::vector<unsigned int> > resim_levels;
+
     bool disable_signature_clear;
+
+    //! position of each instance (by id) in lib_insts, -1 if none
+    std::vector<int> lib_positions;
+
+    //! levelization pass of each lib_insts entry (orders linsts)
+    std::vector<unsigned int> level_passes;
+
+    /*!
+     * Gates reading each lib_insts entry (positions), for finding the
+     * cone of new gates.  Lists may hold gates that no longer read
+     * the entry.
+    */
+    ListStore<unsigned int> level_fanouts;
+    std::vector<ListRange> level_fanout_lists;
+
+    //! region index of each lib_insts position (levelization work space)
+    std::vector<unsigned int> region_index;
 };
 
 
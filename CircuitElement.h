@@ -2,35 +2,47 @@
 #define CIRCUITELEMENT_H
 
 #include <string>
+#include "Netlist.h"
 
 //! element type
 enum CircuitElementType {INST, WIRE, PORT};
 
 
 /*!
- * Base class for wire, intance, and port types.
- * Contains basics information for name and type
+ * Base class for wire and intance types.
+ * Contains basics information for name (interned in the netlist),
+ * type and id (position in the netlist)
 */
 class CircuitElement {
   public:
-    CircuitElement(std::string name_) : name(name_), visited(false) {}
-    std::string get_name() const
+    CircuitElement(unsigned int name_id_, Netlist* netlist_, CircuitElementType type_,
+            unsigned int id_) :
+        netlist(netlist_), name_id(name_id_), id(id_), type(type_) {}
+    const std::string& get_name() const
     {
-        return name;
+        return netlist->names.get(name_id);
     }
-    virtual CircuitElementType get_type() const = 0;
-    void set_visited(bool val)
+    //! symbol id of the name
+    unsigned int get_name_id() const
     {
-        visited = val;
+        return name_id;
     }
-    bool is_visited() const
+    CircuitElementType get_type() const
     {
-        return visited;
+        return CircuitElementType(type);
     }
+    unsigned int get_id() const
+    {
+        return id;
+    }
+
+  protected:
+    Netlist* netlist;
         
   private:
-    std::string name;
-    bool visited;
+    unsigned int name_id;
+    unsigned int id;
+    unsigned char type;
 };
 
 #endif
@@ -37,6 +37,9 @@ bool CrackKey::generate_key(vector<bool>& key_values, int rand_sim,
         num_tests += rand_sim;    
     }
    
+    // the unlocked circuit responses do not change during the search
+    compute_golden_responses(use_test, use_rand);
+
     // to account for the initial simulation 
     num_input_patterns = num_tests;
     
@@ -51,16 +54,22 @@ bool CrackKey::generate_key(vector<bool>& key_values, int rand_sim,
 
     vector<int> key_same;
 
+    // false when keys were reassigned and the signatures must be recomputed
+    bool sigs_current = false;
+
     //while (num_input_patterns < SEARCH_LIMIT) {
     //while (((clock() - initial_clock) / double(CLOCKS_PER_SEC)) < timeout) {
     while (num_iterations < SEARCH_LIMIT) {
 
-        // in theory, outputs could be saved from previous
-        // configuration (this doesn't count against num_input_patterns)
-        simulate_circuits(use_test, use_rand);
+        // outputs are saved from the previous configuration
+        // (this doesn't count against num_input_patterns)
+        if (!sigs_current) {
+            simulate_locked_circuit(use_test, use_rand);
+            sigs_current = true;
+        }
         int num_bad_outputs1, num_bad_vectors1;
 
-        locked_circuit->output_differences(unlocked_circuit, num_bad_outputs1, num_bad_vectors1);
+        locked_circuit->output_differences(golden_responses, num_bad_outputs1, num_bad_vectors1);
 
         if (num_examined == num_keys) {
             int matches = 0;
@@ -95,6 +104,7 @@ bool CrackKey::generate_key(vector<bool>& key_values, int rand_sim,
             if (last_bad == num_bad_vectors1 && num_bads == 2) {
                 cout << "randomizing" << endl;
                 locked_circuit->randomly_set_keys();
+                sigs_current = false;
                 num_input_patterns += num_tests; 
                 num_bads = 0;
 
@@ -120,19 +130,19 @@ bool CrackKey::generate_key(vector<bool>& key_values, int rand_sim,
         examined[choose_key] = true;        
 
         locked_circuit->toggle_key(choose_key);
-        simulate_circuits(use_test, use_rand);
+        locked_circuit->resimulate_key(choose_key);
         num_input_patterns += num_tests; 
         ++num_iterations;
 
         int num_bad_outputs2, num_bad_vectors2;
-        locked_circuit->output_differences(unlocked_circuit, num_bad_outputs2, num_bad_vectors2); 
+        locked_circuit->output_differences(golden_responses, num_bad_outputs2, num_bad_vectors2); 
 
         int num_bad_vectors = num_bad_vectors2;
         if (//(num_bad_outputs1 < num_bad_outputs2) ||
               //  ((num_bad_outputs1 == num_bad_outputs2) &&
                  (num_bad_vectors1 <= num_bad_vectors2)) {
             locked_circuit->toggle_key(choose_key);
-            //simulate_circuits(use_test, use_rand);
+            locked_circuit->resimulate_key(choose_key);
             num_bad_vectors = num_bad_vectors1;
         }
 
@@ -206,6 +216,7 @@ bool CrackKey::generate_key(vector<bool>& key_values, int rand_sim,
                     locked_circuit->randomly_set_keys();
                     num_input_patterns += num_tests; 
                 }
+                sigs_current = false;
            
                 if (num_restarts > 10) {
                     for (int i = 0; i < num_keys; ++i) {
@@ -234,21 +245,52 @@ bool CrackKey::generate_key(vector<bool>& key_values, int rand_sim,
     return found;
 }
 
-void CrackKey::simulate_circuits(bool use_test, bool use_rand)
+void CrackKey::simulate_locked_circuit(bool use_test, bool use_rand)
 {
     if (use_rand) {
         locked_circuit->simulate_random();
-        unlocked_circuit->simulate_random();
         locked_circuit->set_disable_signature_clear(true);
-        unlocked_circuit->set_disable_signature_clear(true);
     }
     if (use_test) {
         locked_circuit->simulate_test();
-        unlocked_circuit->simulate_test();
     }
 
     locked_circuit->set_disable_signature_clear(false);
-    unlocked_circuit->set_disable_signature_clear(false);
+}
+
+void CrackKey::compute_golden_responses(bool use_test, bool use_rand)
+{
+    // only the outputs of the unlocked circuit are compared
+    unlocked_circuit->set_signature_retention(RETAIN_OUTPUTS);
+
+    Circuit::ResponseMatrix test_responses;
+    bool saved = false;
+    if (use_test && (response_file != "")) {
+        saved = unlocked_circuit->read_test_responses(response_file, test_responses);
+    }
+    if (use_test && !saved) {
+        unlocked_circuit->simulate_test();
+        unlocked_circuit->get_output_responses(test_responses);
+        if (response_file != "") {
+            unlocked_circuit->write_test_responses(response_file, test_responses);
+        }
+    }
+
+    golden_responses.clear();
+    if (use_rand) {
+        unlocked_circuit->simulate_random();
+        unlocked_circuit->get_output_responses(golden_responses);
+    }
+
+    // test vector responses follow the random vector responses
+    if (golden_responses.empty()) {
+        golden_responses = test_responses;
+    } else {
+        for (int i = 0; i < int(test_responses.size()); ++i) {
+            golden_responses[i].insert(golden_responses[i].end(),
+                    test_responses[i].begin(), test_responses[i].end());
+        }
+    }
 }
 
 void CrackKey::print_info()
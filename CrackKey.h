@@ -2,8 +2,9 @@
 #define CRACKKEY_H
 
 #include <vector>
+#include <string>
+#include "Circuit.h"
 
-class Circuit;
 class EncryptedCircuit;
 
 class CrackKey {
@@ -22,15 +23,39 @@ class CrackKey {
 
     void print_info();
 
-    void simulate_circuits(bool use_test, bool use_rand);
+    /*!
+     * Responses of the unlocked circuit to the test vectors are read
+     * from (or saved to) this file instead of being simulated.
+    */
+    void set_response_file(std::string response_file_)
+    {
+        response_file = response_file_;
+    }
+
+    /*!
+     * Simulate the locked circuit with the search patterns (random
+     * vectors followed by test vectors).
+    */
+    void simulate_locked_circuit(bool use_test, bool use_rand);
 
   private:
+    /*!
+     * Compute the unlocked circuit responses to the search patterns
+     * once per crack.
+    */
+    void compute_golden_responses(bool use_test, bool use_rand);
+
     Circuit* unlocked_circuit;
     EncryptedCircuit* locked_circuit;
 
     int num_iterations;
     int num_input_patterns;
     int num_restarts; 
+
+    std::string response_file;
+
+    //! unlocked circuit responses to the search patterns
+    Circuit::ResponseMatrix golden_responses;
 };
 
 
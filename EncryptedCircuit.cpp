@@ -3,12 +3,16 @@
 #include "Wire.h"
 #include "Inst.h"
 #include "Port.h"
+#include "SignatureIndex.h"
+#include "ThreadPool.h"
 
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <tr1/unordered_map>
 #include <boost/functional/hash.hpp>
+#include <boost/bind.hpp>
 
 using std::cout; using std::endl;
 using std::vector; using std::tr1::unordered_map;
@@ -26,6 +30,28 @@ const char * XNOR_BLIF = "00 1\n11 1\n";
 const char * AND_BLIF = "11 1\n";
 const char * OR_BLIF = "01 1\n10 1\n11 1\n";
 
+EncryptedCircuit::EncryptedCircuit(string filename, TechLibrary* library_) :
+    Circuit(filename, library_)
+{
+    key_wires = loaded_keys.wires;
+    new_gates = loaded_keys.new_gates;
+    for (int i = 0; i < int(key_wires.size()); ++i) {
+        key_values[key_wires[i]->get_name()] = loaded_keys.values[i];
+    }
+    loaded_keys = KeySection();
+}
+
+void EncryptedCircuit::get_key_section(KeySection& keys)
+{
+    keys.wires = key_wires;
+    keys.new_gates = new_gates;
+    keys.values.clear();
+    for (int i = 0; i < int(key_wires.size()); ++i) {
+        unordered_map<Key, int>::iterator iter = key_values.find(key_wires[i]->get_name());
+        keys.values.push_back((iter != key_values.end()) ? iter->second : 0);
+    }
+}
+
 void EncryptedCircuit::print_keys()
 {
     for (unordered_map<Key, int>::iterator iter = key_values.begin();
@@ -68,6 +94,14 @@ void EncryptedCircuit::toggle_key(unsigned int key_id)
     }
 }
 
+void EncryptedCircuit::resimulate_key(unsigned int key_id)
+{
+    if (key_id >= key_wires.size()) {
+        throw Error("Invalid key id given");
+    } 
+    resimulate_from(key_wires[key_id]);
+}
+
 void EncryptedCircuit::set_key_value(unsigned int key_id, int val)
 {
     if (key_id >= key_wires.size()) {
@@ -105,64 +139,81 @@ void EncryptedCircuit::correctly_set_keys()
     }
 }
 
-CoverType EncryptedCircuit::find_cover(Wire* wire1, Wire* wire2, Circuit& validation_circuit)
+// wire of the validation circuit with the same name
+static Wire* validation_wire(Wire* wire, const vector<Wire*>& validation_wires)
 {
-    if (wire1->sig_equiv(*wire2, EQUAL)) {
-        if (!(validation_circuit.wires_equal(wire1->get_name(), wire2->get_name(), EQUAL))) {
-            return EQUAL;
-        }
+    Wire* match = validation_wires[wire->get_id()];
+    if (!match) {
+        throw Error("Wire " + wire->get_name() + " is not in the validation circuit");
     }
+    return match;
+}
 
-    if (wire1->sig_equiv(*wire2, AND)) {
-        if (!(validation_circuit.wires_equal(wire1->get_name(), wire2->get_name(), AND))) {
-            return AND;
-        }
-    }
+CoverType EncryptedCircuit::find_cover(unsigned int entry1, unsigned int entry2,
+        unsigned int covers, const SignatureIndex& validation_index) const
+{
+    unsigned int validated = validation_index.entry_covers(entry1, entry2, covers);
 
-    if (wire1->sig_equiv(*wire2, OR)) {
-        if (!(validation_circuit.wires_equal(wire1->get_name(), wire2->get_name(), OR))) {
-            return OR;
+    // first of EQUAL, AND, OR that the validation simulation breaks
+    const CoverType types[] = { EQUAL, AND, OR };
+    for (int i = 0; i < 3; ++i) {
+        if ((covers & cover_bit(types[i])) && !(validated & cover_bit(types[i]))) {
+            return types[i];
         }
     }
-
-   return NOCOVER;
+    return NOCOVER;
 }
 
 void EncryptedCircuit::add_test_mux(int num_muxes, bool get_cands)
 {
     TechLibrary library;
     Circuit validation_circuit(blif_name, &library);
+
+    // elements of this circuit in the validation circuit
+    vector<Wire*> validation_wires;
+    vector<Inst*> validation_insts;
+    validation_circuit.match_elements(*this, validation_wires, validation_insts);
     
     int num_ops = linsts.size();
     simulate_test();
     validation_circuit.simulate(2048);
 
+    // candidates for covers among the wires that are not outputs (by
+    // linsts position), with their signatures in both circuits
+    vector<Wire*> cover_wires(linsts.size(), 0);
+    vector<Wire*> validation_cover_wires(linsts.size(), 0);
+    for (int i = 0; i < int(linsts.size()); ++i) {
+        Wire* owire = linsts[i]->get_output(0)->get_wire();
+        if (!owire->is_output()) {
+            cover_wires[i] = owire;
+            validation_cover_wires[i] = validation_wire(owire, validation_wires);
+        }
+    }
+    SignatureIndex cover_index(cover_wires);
+    SignatureIndex validation_index(validation_cover_wires);
+
     // find all candidates 
     if (get_cands) {
-        int num_tot_cands = 0;
-        int num_wire_cands = 0;
-        for (int i = (linsts.size() - 1); i >= 1; --i) {
-            Wire* owire = linsts[i]->get_output(0)->get_wire();
-            if (owire->is_output()) {
+        for (int i = int(linsts.size()) - 1; i >= 1; --i) {
+            if (!cover_wires[i]) {
                 --num_ops;
-                continue;
-            } 
+            }
+        }
 
-            bool found = false; 
-            for (int j = (i-1); j >= 0; --j) {
-                Wire* owire2 = linsts[j]->get_output(0)->get_wire();
-                if (owire2->is_output()) {
-                    continue;
-                }
-                CoverType cover = find_cover(owire, owire2, validation_circuit);
+        // the entries are split across the tasks in turn since the
+        // scans get longer with the position
+        vector<int> num_cands(linsts.size(), 0);
+        ThreadPool& pool = ThreadPool::instance();
+        int num_tasks = pool.get_num_threads();
+        pool.run(num_tasks, boost::bind(&EncryptedCircuit::count_covers_task, this, _1,
+                    num_tasks, &cover_index, &validation_index, &num_cands));
 
-                if (cover != NOCOVER) {
-                    ++num_tot_cands;
-                    if (!found) {
-                        ++num_wire_cands;
-                    }
-                    found = true;
-                }
+        int num_tot_cands = 0;
+        int num_wire_cands = 0;
+        for (int i = 0; i < int(num_cands.size()); ++i) {
+            num_tot_cands += num_cands[i];
+            if (num_cands[i] > 0) {
+                ++num_wire_cands;
             }
         }
         cout << "Number of total wires: " << num_ops << endl;
@@ -174,10 +225,14 @@ void EncryptedCircuit::add_test_mux(int num_muxes, bool get_cands)
     vector<pair<Wire*, Wire*> > muxed_wires;
     vector<CoverType> muxed_types;
     int total_nonobservable = 0;
+    vector<CoverCheck> checks;
+    vector<unsigned int> check_ids;
+    int batch_size = ThreadPool::instance().get_num_threads();
     
     {
     ScopeTime timer;
     cout << "Finding MUX covers in circuit" << endl;
+    marks.start(netlist);
     while (num_muxes > 0) {
         if (num_ops < num_muxes) {
             throw Error("Request for more keys than gates");
@@ -185,10 +240,9 @@ void EncryptedCircuit::add_test_mux(int num_muxes, bool get_cands)
 
         int id = (rand() % (linsts.size()));
         Inst* inst = linsts[id];
-        if (inst->is_visited()) {
+        if (!marks.visit(inst)) {
             continue;
         }
-        inst->set_visited(true);
        
         Wire* owire = inst->get_output(0)->get_wire();
         if (owire->is_output()) {
@@ -196,35 +250,55 @@ void EncryptedCircuit::add_test_mux(int num_muxes, bool get_cands)
             continue;
         } 
 
+        // the first observable candidate in scan order is taken: the
+        // candidates are confirmed in batches of one per thread, so the
+        // choice does not depend on the number of threads
         bool found = false;
-        for (int j = (id-1); j >=0; --j) {
-            if (muxed_ids.find(j) != muxed_ids.end()) {
-                continue;
-            }
-            Wire* owire2 = linsts[j]->get_output(0)->get_wire();
-            if (owire2->is_output()) {
-                continue;
-            }
-            CoverType cover = find_cover(owire, owire2, validation_circuit);
-
-            if (cover != NOCOVER) {
-                // check observable
-                bool observable = validation_circuit.observable_cover(
-                        linsts[id]->get_name(), owire2->get_name(), cover);
-
-                if (observable) {
-                    linsts[j]->set_visited(true);
-                    muxed_ids.insert(id); 
-                    muxed_ids.insert(j);
-                    muxed_wires.push_back(make_pair(owire, owire2));
-                    muxed_types.push_back(cover); 
-                    found = true;
+        bool scanned = false;
+        Inst* valid_inst = 0;
+        SignatureIndex::Scan scan = cover_index.start_scan(id, id);
+        while (!found && !scanned) {
+            checks.clear();
+            check_ids.clear();
+            unsigned int j, covers;
+            while (int(checks.size()) < batch_size) {
+                if (!cover_index.next_cover(scan, j, covers)) {
+                    scanned = true;
                     break;
-                } else {
-                    ++total_nonobservable;
                 }
+                if (muxed_ids.find(j) != muxed_ids.end()) {
+                    continue;
+                }
+                CoverType cover = find_cover(id, j, covers, validation_index);
+                if (cover == NOCOVER) {
+                    continue;
+                }
+                if (!valid_inst) {
+                    valid_inst = validation_insts[inst->get_id()];
+                    if (!valid_inst) {
+                        throw Error("Instance " + inst->get_name() +
+                                " is not in the validation circuit");
+                    }
+                }
+                checks.push_back(CoverCheck(valid_inst, validation_cover_wires[j], cover));
+                check_ids.push_back(j);
             }
 
+            validation_circuit.observable_covers(checks);
+            for (int k = 0; k < int(checks.size()); ++k) {
+                if (!checks[k].observable) {
+                    ++total_nonobservable;
+                    continue;
+                }
+                unsigned int j = check_ids[k];
+                marks.mark(linsts[j]);
+                muxed_ids.insert(id); 
+                muxed_ids.insert(j);
+                muxed_wires.push_back(make_pair(owire, cover_wires[j]));
+                muxed_types.push_back(checks[k].cover); 
+                found = true;
+                break;
+            }
         }
 
         if (!found) {
@@ -248,8 +322,9 @@ void EncryptedCircuit::add_test_mux(int num_muxes, bool get_cands)
         if (cover != EQUAL) {
             inst_cover = create_cover(inst_correct, inst_cover, cover);
         }
+        // keys of earlier locking calls keep their names
         stringstream keyss;
-        keyss << "key-" << i;
+        keyss << "key-" << key_wires.size();
         string key = keyss.str();
         int value = rand() % 2;
         key_values[key] = value;
@@ -258,44 +333,103 @@ void EncryptedCircuit::add_test_mux(int num_muxes, bool get_cands)
     }
     }
 
-    for (int i = 0; i < int(linsts.size()); ++i) {
-        // clear flags
-        linsts[i]->set_visited(false);
-    }
+    levelize_new_insts();
+}
 
-    levelize();
+void EncryptedCircuit::count_covers_task(int task, int num_tasks,
+        const SignatureIndex* cover_index, const SignatureIndex* validation_index,
+        vector<int>* num_cands) const
+{
+    for (int i = int(num_cands->size()) - 1 - task; i >= 1; i -= num_tasks) {
+        if (!linsts[i]->get_output(0)->get_wire()->is_output()) {
+            SignatureIndex::Scan scan = cover_index->start_scan(i, i);
+            unsigned int j, covers;
+            while (cover_index->next_cover(scan, j, covers)) {
+                if (find_cover(i, j, covers, *validation_index) != NOCOVER) {
+                    ++(*num_cands)[i];
+                }
+            }
+        }
+    }
 }
 
 void EncryptedCircuit::print_testability_prob(unordered_set<Inst*>& stuck0, unordered_set<Inst*>& stuck1)
 {
     simulate_test();
+    vector<SimValues> round_sources(1);
+    load_sim_values(round_sources[0]);
+    print_testability_rounds(round_sources, stuck0, stuck1);
+}
+
+void EncryptedCircuit::print_testability_prob(int num_rounds,
+        unordered_set<Inst*>& stuck0, unordered_set<Inst*>& stuck1)
+{
+    // keys are drawn in round order so the random sequence is unchanged
+    vector<SimValues> round_sources(num_rounds);
+    for (int i = 0; i < num_rounds; ++i) {
+        randomly_set_keys();
+        load_sim_values(round_sources[i]);
+    }
+    simulate_test();
+    print_testability_rounds(round_sources, stuck0, stuck1);
+}
+
+void EncryptedCircuit::print_testability_rounds(const vector<SimValues>& round_sources,
+        unordered_set<Inst*>& stuck0, unordered_set<Inst*>& stuck1)
+{
     int num_sites = 0;
     int num_found = 0;
-    for (int i = 0; i < linsts.size(); ++i) {
+
+    // faults found before these rounds are not simulated again
+    // the inserted gates are not fault sites
+    marks.start(netlist);
+    for (int i = 0; i < int(new_gates.size()); ++i) {
+        marks.mark(new_gates[i]);
+    }
+    vector<Fault> faults;
+    for (std::size_t i = 0; i < linsts.size(); ++i) {
         Wire* owire = linsts[i]->get_output(0)->get_wire();
         if (owire->is_output()) {
             continue;
         }
-        if (linsts[i]->is_visited()) {
+        if (marks.is_marked(linsts[i])) {
             continue;
         }
 
         num_sites += 2;
-        if ((stuck1.find(linsts[i]) != stuck1.end()) ||
-                observable_signal(linsts[i], STUCK1)) {
-            stuck1.insert(linsts[i]);
+        if (stuck1.find(linsts[i]) != stuck1.end()) {
             ++num_found;
+        } else {
+            faults.push_back(Fault(linsts[i], STUCK1));
         }
-        if ((stuck0.find(linsts[i]) != stuck1.end()) ||
-                observable_signal(linsts[i], STUCK0)) {
-            stuck0.insert(linsts[i]);
+        if (stuck0.find(linsts[i]) != stuck0.end()) {
             ++num_found;
+        } else {
+            faults.push_back(Fault(linsts[i], STUCK0));
         }
     } 
+
+    vector<vector<Fault> > round_faults(round_sources.size(), faults);
+    simulate_faults(round_faults, round_sources);
+
+    // merge the rounds in order
+    for (int r = 0; r < int(round_faults.size()); ++r) {
+        for (int i = 0; i < int(faults.size()); ++i) {
+            if (round_faults[r][i].detected && !faults[i].detected) {
+                faults[i].detected = true;
+                if (faults[i].mod == STUCK1) {
+                    stuck1.insert(faults[i].inst);
+                } else {
+                    stuck0.insert(faults[i].inst);
+                }
+                ++num_found;
+            }
+        }
     
-    cout << "Mux random testability: " << 
-        double(num_found) / double(num_sites) * 100 << "; Num remaining: " 
-        << num_sites - num_found << "; Num faults: " << num_sites << endl;
+        cout << "Mux random testability: " << 
+            double(num_found) / double(num_sites) * 100 << "; Num remaining: " 
+            << num_sites - num_found << "; Num faults: " << num_sites << endl;
+    }
 }
 
 
@@ -303,25 +437,32 @@ void EncryptedCircuit::print_testability_prob(unordered_set<Inst*>& stuck0, unor
 
 
 
-void EncryptedCircuit::add_random_xors(int num_xors)
+void EncryptedCircuit::add_random_xors(int num_xors, bool observable_only)
 {
     int num_ops = linsts.size();
 
     // generate simulation vectors that the testing will work against
     simulate(2048);
 
+    // observability of every gate from one backward pass
+    SignatureMatrix masks;
+    if (observable_only) {
+        observability_masks(masks);
+    }
+
     vector<Inst*> chosen_insts;
     int total_nonobservable = 0;
+    marks.start(netlist);
     while (num_xors > 0) {
         if (num_ops < num_xors) {
             throw Error("Request for more keys than gates");
         }
 
-        Inst* inst = linsts[(rand() % (linsts.size()))];
-        if (inst->is_visited()) {
+        int id = rand() % (linsts.size());
+        Inst* inst = linsts[id];
+        if (!marks.visit(inst)) {
             continue;
         }
-        inst->set_visited(true);
         
         Wire* owire = inst->get_output(0)->get_wire();
         if (owire->is_output()) {
@@ -330,51 +471,91 @@ void EncryptedCircuit::add_random_xors(int num_xors)
         } 
 
         // verify that XOR impacts the output
-        /*if (!observable_signal(inst)) {
-            ++total_nonobservable;
-            --num_ops;
-            continue;
-        } */           
+        if (observable_only) {
+            bool observable = false;
+            const unsigned long long* mask = masks.row(id);
+            for (int i = 0; i < masks.get_num_words(); ++i) {
+                observable = observable || (mask[i] != 0);
+            }
+            if (!observable) {
+                ++total_nonobservable;
+                --num_ops;
+                continue;
+            }
+        }
 
         chosen_insts.push_back(inst);
         --num_xors;
     }
     cout << "Num non-observable: " << total_nonobservable << endl; 
 
+    insert_key_xors(chosen_insts);
+}
+
+void EncryptedCircuit::add_fault_impact_xors(int num_xors)
+{
+    // random vectors that the faults are ranked against
+    simulate(2048);
+    SignatureMatrix masks;
+    observability_masks(masks);
+
+    // a stuck-at fault disturbs the observable patterns where the gate
+    // has the other value, so both faults together disturb all of them
+    vector<pair<int, int> > ranked;
+    for (int i = 0; i < int(linsts.size()); ++i) {
+        if (linsts[i]->get_output(0)->get_wire()->is_output()) {
+            continue;
+        }
+        int impact = 0;
+        const unsigned long long* mask = masks.row(i);
+        for (int j = 0; j < masks.get_num_words(); ++j) {
+            impact += __builtin_popcountll(mask[j]);
+        }
+        ranked.push_back(make_pair(-impact, i));
+    }
+    if (int(ranked.size()) < num_xors) {
+        throw Error("Request for more keys than gates");
+    }
+
+    // highest impact first, ties in linsts order
+    std::partial_sort(ranked.begin(), ranked.begin() + num_xors, ranked.end());
+    vector<Inst*> chosen_insts;
+    for (int i = 0; i < num_xors; ++i) {
+        chosen_insts.push_back(linsts[ranked[i].second]);
+    }
+    cout << "Lowest fault impact: " << -ranked[num_xors - 1].first << " patterns" << endl;
+
+    insert_key_xors(chosen_insts);
+}
 
+void EncryptedCircuit::insert_key_xors(const vector<Inst*>& insts)
+{
     // march through list and randomly choose value, insert logic
-    for (int i = 0; i < int(chosen_insts.size()); ++i) {
+    // (keys of earlier locking calls keep their names)
+    for (int i = 0; i < int(insts.size()); ++i) {
         stringstream keyss;
-        keyss << "key-" << i;
+        keyss << "key-" << key_wires.size();
         string key = keyss.str();
         int value = rand() % 2;
         key_values[key] = value;
    
         // value = 0 add an XOR; value = 1 add an XNOR
         // adds wire to key_wires 
-        insert_xor(chosen_insts[i], key, value);
-    }
-    
-    for (int i = 0; i < int(linsts.size()); ++i) {
-        // clear flags
-        linsts[i]->set_visited(false);
+        insert_xor(insts[i], key, value);
     }
 
-    levelize();
+    levelize_new_insts();
 }
 
 
 
-void EncryptedCircuit::levelize()
+void EncryptedCircuit::mark_sources(TraversalMarks& source_marks)
 {
     // key wires are not added to the circuit input list
     // which is used for levelization
+    Circuit::mark_sources(source_marks);
     for (int i = 0; i < int(key_wires.size()); ++i) {
-        key_wires[i]->set_visited(true);
-    } 
-    Circuit::levelize();
-    for (int i = 0; i < int(key_wires.size()); ++i) {
-        key_wires[i]->set_visited(false);
+        source_marks.mark(key_wires[i]);
     } 
 }
     
@@ -384,12 +565,12 @@ Inst* EncryptedCircuit::create_cover(Inst* inst_correct, Inst* inst_cover, Cover
     string wire_name = inst_correct->get_output(0)->get_wire()->get_name() + "-cover";
     string inst_name = wire_name + "name";
 
-    Inst* new_inst = new Inst(inst_name); 
+    Inst* new_inst = netlist.create_inst(inst_name); 
     new_gates.push_back(new_inst);
     lib_insts.push_back(new_inst);
     ++num_insts;
     ++num_gates;
-    sym_table[inst_name] = new_inst;
+    add_symbol(new_inst);
     lib_cell* cell;
 
     // input 0 is the correct signal, input 1 is the cover
@@ -403,18 +584,18 @@ Inst* EncryptedCircuit::create_cover(Inst* inst_correct, Inst* inst_cover, Cover
     new_inst->add_lib_cell(cell);
 
     // create output port and assign wire
-    Port *oport = new Port(wire_name);
+    Port *oport = netlist.create_port(wire_name);
     ++num_ports;
     oport->set_inst(new_inst);
     new_inst->add_output(oport);
-    Wire* owire = new Wire(wire_name);
+    Wire* owire = netlist.create_wire(wire_name);
     ++num_wires;
-    sym_table[wire_name] = owire;
+    add_symbol(owire);
     owire->set_driver(oport);
 
     // create MUX second input
     string cov_name1 = wire_name + "-in1";
-    Port *port1 = new Port(cov_name1);
+    Port *port1 = netlist.create_port(cov_name1);
     ++num_ports;
     new_inst->add_input(port1);
     port1->set_inst(new_inst);
@@ -422,7 +603,7 @@ Inst* EncryptedCircuit::create_cover(Inst* inst_correct, Inst* inst_cover, Cover
 
     // create MUX third input 
     string cov_name2 = wire_name + "-in2";
-    Port *port2 = new Port(cov_name2);
+    Port *port2 = netlist.create_port(cov_name2);
     ++num_ports;
     new_inst->add_input(port2);
     port2->set_inst(new_inst);
@@ -436,12 +617,12 @@ void EncryptedCircuit::insert_mux(Inst* inst, Inst* cover, string key_name, int
     // create XOR/XNOR instance
     string key_out = key_name + "-mux";
     string inst_name = key_out+"name";
-    Inst* new_inst = new Inst(inst_name); 
+    Inst* new_inst = netlist.create_inst(inst_name); 
     new_gates.push_back(new_inst);
     lib_insts.push_back(new_inst);
     ++num_insts;
     ++num_gates;
-    sym_table[inst_name] = new_inst;
+    add_symbol(new_inst);
     lib_cell* cell;
 
     // input 0 is select, input 1 is the actual signal, input 2 is the cover
@@ -453,13 +634,13 @@ void EncryptedCircuit::insert_mux(Inst* inst, Inst* cover, string key_name, int
     new_inst->add_lib_cell(cell);
 
     // create output port and assign wire
-    Port *oport = new Port(key_out);
+    Port *oport = netlist.create_port(key_out);
     ++num_ports;
     oport->set_inst(new_inst);
     new_inst->add_output(oport);
-    Wire* owire = new Wire(key_out);
+    Wire* owire = netlist.create_wire(key_out);
     ++num_wires;
-    sym_table[key_out] = owire;
+    add_symbol(owire);
     owire->set_driver(oport);
 
     // grab inst output wire
@@ -469,27 +650,26 @@ void EncryptedCircuit::insert_mux(Inst* inst, Inst* cover, string key_name, int
     Wire* reconnect_wire = inst->get_output(0)->get_wire();
 
     // create XOR key input and wire
-    Port *port1 = new Port(key_name);
+    Port *port1 = netlist.create_port(key_name);
     ++num_ports;
     new_inst->add_input(port1); 
     port1->set_inst(new_inst);
-    Wire* wire1 = new Wire(key_name);
-    // make sure key wire is marked as visited; should not be visited
+    Wire* wire1 = netlist.create_wire(key_name);
     ++num_wires;
-    sym_table[key_name] = wire1;
+    add_symbol(wire1);
     wire1->add_output_port(port1);
     key_wires.push_back(wire1);  
 
     // create MUX second input
     string mux_byname = key_name + "-by1";
-    Port *port2 = new Port(mux_byname);
+    Port *port2 = netlist.create_port(mux_byname);
     ++num_ports;
     new_inst->add_input(port2);
     port2->set_inst(new_inst);
 
     // create MUX third input 
     string mux_byname2 = key_name + "-by2";
-    Port *port3 = new Port(mux_byname2);
+    Port *port3 = netlist.create_port(mux_byname2);
     ++num_ports;
     new_inst->add_input(port3);
     port3->set_inst(new_inst);
@@ -503,10 +683,10 @@ void EncryptedCircuit::insert_mux(Inst* inst, Inst* cover, string key_name, int
 
     // create key input
     string inst_inname = key_name + "_input";
-    Inst* inst_in = new Inst(inst_inname, true);
+    Inst* inst_in = netlist.create_inst(inst_inname, true);
     ++num_insts;
-    sym_table[inst_inname] = inst_in;
-    oport = new Port(key_name);
+    add_symbol(inst_in);
+    oport = netlist.create_port(key_name);
     ++num_ports;
     inst_in->add_output(oport);
     oport->set_inst(inst);
@@ -519,12 +699,12 @@ void EncryptedCircuit::insert_xor(Inst* inst, string key_name, int value)
     // create XOR/XNOR instance
     string key_out = key_name + "-xor";
     string inst_name = key_out+"name";
-    Inst* new_inst = new Inst(inst_name); 
+    Inst* new_inst = netlist.create_inst(inst_name); 
     lib_insts.push_back(new_inst);
     new_gates.push_back(new_inst);
     ++num_insts;
     ++num_gates;
-    sym_table[inst_name] = new_inst;
+    add_symbol(new_inst);
     lib_cell* cell;
     if (value) {
         cell = library->create_libcell(XNOR_BLIF, 2);
@@ -534,13 +714,13 @@ void EncryptedCircuit::insert_xor(Inst* inst, string key_name, int value)
     new_inst->add_lib_cell(cell);
 
     // create output port and assign wire
-    Port *oport = new Port(key_out);
+    Port *oport = netlist.create_port(key_out);
     ++num_ports;
     oport->set_inst(new_inst);
     new_inst->add_output(oport);
-    Wire* owire = new Wire(key_out);
+    Wire* owire = netlist.create_wire(key_out);
     ++num_wires;
-    sym_table[key_out] = owire;
+    add_symbol(owire);
     owire->set_driver(oport);
 
     // grab inst output wire
@@ -550,20 +730,19 @@ void EncryptedCircuit::insert_xor(Inst* inst, string key_name, int value)
     Wire* reconnect_wire = inst->get_output(0)->get_wire();
 
     // create XOR key input and wire
-    Port *port1 = new Port(key_name);
+    Port *port1 = netlist.create_port(key_name);
     ++num_ports;
     new_inst->add_input(port1); 
     port1->set_inst(new_inst);
-    Wire* wire1 = new Wire(key_name);
-    // make sure key wire is marked as visited; should not be visited
+    Wire* wire1 = netlist.create_wire(key_name);
     ++num_wires;
-    sym_table[key_name] = wire1;
+    add_symbol(wire1);
     wire1->add_output_port(port1);
     key_wires.push_back(wire1);  
 
     // create XOR second input
     string xor_byname = key_name + "-by";
-    Port *port2 = new Port(xor_byname);
+    Port *port2 = netlist.create_port(xor_byname);
     ++num_ports;
     new_inst->add_input(port2);
     port2->set_inst(new_inst);
@@ -576,10 +755,10 @@ void EncryptedCircuit::insert_xor(Inst* inst, string key_name, int value)
 
     // create key input
     string inst_inname = key_name + "_input";
-    Inst* inst_in = new Inst(inst_inname, true);
+    Inst* inst_in = netlist.create_inst(inst_inname, true);
     ++num_insts;
-    sym_table[inst_inname] = inst_in;
-    oport = new Port(key_name);
+    add_symbol(inst_in);
+    oport = netlist.create_port(key_name);
     ++num_ports;
     inst_in->add_output(oport);
     oport->set_inst(inst);
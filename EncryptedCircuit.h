@@ -3,6 +3,8 @@
 
 #include "Circuit.h"
 
+class SignatureIndex;
+
 typedef std::string Key;
 
 /*!
@@ -10,14 +12,28 @@ typedef std::string Key;
 */
 class EncryptedCircuit : public Circuit {
   public:
-    EncryptedCircuit(std::string filename, TechLibrary* library_) :
-        Circuit(filename, library_) {}
+    /*!
+     * Keys and inserted gates are restored when reading the binary
+     * netlist of a locked circuit.
+    */
+    EncryptedCircuit(std::string filename, TechLibrary* library_);
 
     /*!
      * Adds XOR locking gates randomly to the circuit.  There will
-     * be an error if one attempts to add too many XORs.
+     * be an error if one attempts to add too many XORs.  With
+     * observable_only, gates whose output changes no output for the
+     * random simulation vectors are skipped.
     */
-    void add_random_xors(int num_xors);
+    void add_random_xors(int num_xors, bool observable_only = false);
+
+    /*!
+     * Adds XOR locking gates at the gates whose stuck-at faults disturb
+     * the most random simulation patterns, ranked from the
+     * observability masks of one batched fault simulation pass.  Only
+     * the disturbed patterns are counted, not how many outputs each
+     * pattern disturbs (that would need one propagation per fault).
+    */
+    void add_fault_impact_xors(int num_xors);
    
     /*!
      * Adds MUXes between two signals to preserve testing.
@@ -34,6 +50,12 @@ class EncryptedCircuit : public Circuit {
     */ 
     void toggle_key(unsigned int key_id);
 
+    /*!
+     * Update the saved signatures for the current value of a key
+     * (see Circuit::resimulate_from).
+    */
+    void resimulate_key(unsigned int key_id);
+
     /*!
      * Randomly set the value of all of the keys.
     */
@@ -49,6 +71,13 @@ class EncryptedCircuit : public Circuit {
     void print_testability_prob(std::tr1::unordered_set<Inst*>& stuck0,
         std::tr1::unordered_set<Inst*>& stuck1);
 
+    /*!
+     * Same as calling randomly_set_keys and print_testability_prob
+     * num_rounds times, but the rounds are simulated in parallel.
+    */
+    void print_testability_prob(int num_rounds, std::tr1::unordered_set<Inst*>& stuck0,
+        std::tr1::unordered_set<Inst*>& stuck1);
+
     int get_num_keys() const
     {
         return key_wires.size();
@@ -57,13 +86,17 @@ class EncryptedCircuit : public Circuit {
     bool get_key_value(unsigned int id);
     bool get_current_key_value(unsigned int id);
 
-    void levelize();
- 
     std::vector<Inst*> get_new_gates()
     {
         return new_gates;
     }
 
+  protected:
+    void get_key_section(KeySection& keys);
+
+    //! key wires are sources too
+    void mark_sources(TraversalMarks& source_marks);
+
   private:
     Inst* create_cover(Inst* inst_correct, Inst* inst_cover, CoverType cover);
 
@@ -71,7 +104,32 @@ class EncryptedCircuit : public Circuit {
 
     void insert_xor(Inst* inst, std::string name, int value);
 
-    CoverType find_cover(Wire* wire1, Wire* wire2, Circuit& validation_circuit);
+    //! insert an XOR/XNOR with a random key value after each instance
+    void insert_key_xors(const std::vector<Inst*>& insts);
+
+    /*!
+     * Cover of entry1 by entry2 that holds for the test vectors (the
+     * covers found by the index of this circuit) but not for the
+     * simulation of the validation circuit (validation_index has the
+     * same entries).
+    */
+    CoverType find_cover(unsigned int entry1, unsigned int entry2, unsigned int covers,
+            const SignatureIndex& validation_index) const;
+
+    /*!
+     * Count the covers found for the entries of one task (entries are
+     * dealt to the tasks in turn from the last one).
+    */
+    void count_covers_task(int task, int num_tasks, const SignatureIndex* cover_index,
+            const SignatureIndex* validation_index, std::vector<int>* num_cands) const;
+
+    /*!
+     * Test coverage of each key assignment (source values), adding
+     * the detected faults to the stuck sets in round order.  The
+     * inserted gates are not fault sites.
+    */
+    void print_testability_rounds(const std::vector<SimValues>& round_sources,
+        std::tr1::unordered_set<Inst*>& stuck0, std::tr1::unordered_set<Inst*>& stuck1);
   
     //! these are new inputs to the circuit (not in base class PI list)
     std::vector<Wire*> key_wires;
@@ -0,0 +1,425 @@
+#include "FaultSim.h"
+#include "Inst.h"
+#include "Port.h"
+#include "Wire.h"
+
+#include <cstring>
+#include <algorithm>
+#include <tr1/unordered_map>
+
+using std::vector;
+using std::tr1::unordered_map;
+
+//! post-dominators of slots that reach no output / only the common sink
+static const unsigned int POST_DOM_NONE = ~0u;
+static const unsigned int POST_DOM_SINK = ~0u - 1;
+
+FaultSim::FaultSim(const SimProgram& program_, const vector<unsigned int>& observed_slots,
+        const vector<unsigned int>& input_slots_,
+        const vector<vector<unsigned long long> >& input_vectors_, int num_sims_) :
+    program(program_), input_slots(input_slots_), input_vectors(input_vectors_),
+    num_sims(num_sims_), lanes(program_.get_lanes())
+{
+    unsigned int num_slots = program.num_slots();
+    observed.assign(num_slots, false);
+    for (int i = 0; i < int(observed_slots.size()); ++i) {
+        observed[observed_slots[i]] = true;
+    }
+
+    // a slot read by a single operation (and not an output) is inside
+    // the FFR of that operation's output
+    ffr_reader.assign(num_slots, -1);
+    ffr_stem.resize(num_slots);
+    for (unsigned int i = 0; i < num_slots; ++i) {
+        ffr_stem[i] = i;
+        if ((i > 0) && !observed[i] &&
+                ((program.fanout_end(i) - program.fanout_begin(i)) == 1)) {
+            ffr_reader[i] = *(program.fanout_begin(i));
+        }
+    }
+
+    // readers come after the operations they read
+    for (int i = int(program.num_ops()) - 1; i >= 0; --i) {
+        unsigned int out = program.get_op(i).out;
+        if (ffr_reader[out] != -1) {
+            ffr_stem[out] = ffr_stem[program.get_op(ffr_reader[out]).out];
+        }
+    }
+
+    ffr_obs.assign(num_slots * lanes);
+    good_values.assign(num_slots * lanes);
+    faulty_values.assign(num_slots * lanes);
+    scheduled.assign(program.num_ops(), false);
+    num_scheduled = 0;
+    levels.resize(program.get_max_level() + 1);
+}
+
+void FaultSim::run(vector<Fault>& faults, const SimValues& source_values)
+{
+    // simulate one fault per equivalence class
+    vector<SlotFault> classes;
+    vector<int> fault_class(faults.size(), -1);
+    unordered_map<unsigned long long, int> class_ids;
+    for (int i = 0; i < int(faults.size()); ++i) {
+        if (faults[i].detected) {
+            continue;
+        }
+        SlotFault fault;
+        fault.slot = faults[i].inst->get_output(0)->get_wire()->get_slot();
+        fault.mod = faults[i].mod;
+        collapse(fault);
+
+        unsigned long long key = (((unsigned long long)(fault.slot)) << 2) | fault.mod;
+        unordered_map<unsigned long long, int>::iterator iter = class_ids.find(key);
+        if (iter == class_ids.end()) {
+            iter = class_ids.insert(std::make_pair(key, int(classes.size()))).first;
+            classes.push_back(fault);
+        }
+        fault_class[i] = iter->second;
+    }
+
+    // detected faults are dropped from the remaining words
+    vector<bool> detected(classes.size(), false);
+    int num_remaining = classes.size();
+    int num_sig_words = input_vectors.empty() ? 0 : input_vectors[0].size();
+    for (int word = 0; (word < num_sig_words) && (num_remaining > 0); word += lanes) {
+        int num_words = std::min(lanes, num_sig_words - word);
+        load_good_values(source_values, word, num_words);
+        trace_ffrs();
+
+        for (int i = 0; i < int(classes.size()); ++i) {
+            if (!detected[i] && detect(classes[i], num_words)) {
+                detected[i] = true;
+                --num_remaining;
+            }
+        }
+    }
+
+    for (int i = 0; i < int(faults.size()); ++i) {
+        if ((fault_class[i] != -1) && detected[fault_class[i]]) {
+            faults[i].detected = true;
+        }
+    }
+}
+
+void FaultSim::collapse(SlotFault& fault) const
+{
+    while (ffr_reader[fault.slot] != -1) {
+        const SimOp& op = program.get_op(ffr_reader[fault.slot]);
+        if (observed[op.out]) {
+            return;
+        }
+
+        // the faulty input forces the output of the reader
+        ModType mod;
+        if (op.code == SIM_BUF) {
+            mod = fault.mod;
+        } else if (op.code == SIM_NOT) {
+            mod = (fault.mod == STUCK0) ? STUCK1 : ((fault.mod == STUCK1) ? STUCK0 : FLIP);
+        } else if ((op.code == SIM_AND) && (fault.mod == STUCK0)) {
+            mod = STUCK0;
+        } else if ((op.code == SIM_NAND) && (fault.mod == STUCK0)) {
+            mod = STUCK1;
+        } else if ((op.code == SIM_OR) && (fault.mod == STUCK1)) {
+            mod = STUCK1;
+        } else if ((op.code == SIM_NOR) && (fault.mod == STUCK1)) {
+            mod = STUCK0;
+        } else {
+            return;
+        }
+        fault.slot = op.out;
+        fault.mod = mod;
+    }
+}
+
+void FaultSim::load_good_values(const SimValues& source_values, int word, int num_words)
+{
+    for (int l = 0; l < lanes; ++l) {
+        int sims = num_sims - (word + l) * SIGSTEP;
+        lane_sims[l] = (sims >= int(SIGSTEP)) ? SIGSTEP : ((sims > 0) ? sims : 0);
+    }
+
+    memcpy(good_values.get(), source_values.get(),
+            good_values.size() * sizeof(unsigned long long));
+    for (int i = 0; i < int(input_slots.size()); ++i) {
+        unsigned long long* ivalues = good_values.get() + input_slots[i] * lanes;
+        for (int l = 0; l < lanes; ++l) {
+            ivalues[l] = (l < num_words) ? input_vectors[i][word + l] : 0;
+        }
+    }
+    program.run(good_values.get(), lane_sims, 0, program.num_ops());
+
+    memcpy(faulty_values.get(), good_values.get(),
+            good_values.size() * sizeof(unsigned long long));
+}
+
+void FaultSim::trace_ffrs()
+{
+    // stems are reached before the gates of their FFR
+    for (int i = int(program.num_ops()) - 1; i >= 0; --i) {
+        unsigned int out = program.get_op(i).out;
+        unsigned long long* obs = ffr_obs.get() + out * lanes;
+        if (ffr_reader[out] == -1) {
+            for (int l = 0; l < lanes; ++l) {
+                obs[l] = ~((unsigned long long)(0));
+            }
+            continue;
+        }
+
+        // flip the slot and see which patterns change the reader
+        unsigned int reader = ffr_reader[out];
+        unsigned int rout = program.get_op(reader).out;
+        const unsigned long long* reader_obs = ffr_obs.get() + rout * lanes;
+        const unsigned long long* good_out = good_values.get() + out * lanes;
+        const unsigned long long* good_rout = good_values.get() + rout * lanes;
+        unsigned long long* faulty_out = faulty_values.get() + out * lanes;
+        unsigned long long* faulty_rout = faulty_values.get() + rout * lanes;
+
+        for (int l = 0; l < lanes; ++l) {
+            faulty_out[l] = ~good_out[l];
+        }
+        program.run(faulty_values.get(), lane_sims, reader, reader + 1);
+        for (int l = 0; l < lanes; ++l) {
+            obs[l] = reader_obs[l] & (faulty_rout[l] ^ good_rout[l]);
+            faulty_out[l] = good_out[l];
+            faulty_rout[l] = good_rout[l];
+        }
+    }
+}
+
+bool FaultSim::detect(const SlotFault& fault, int num_words)
+{
+    const unsigned long long* good = good_values.get() + fault.slot * lanes;
+    const unsigned long long* obs = ffr_obs.get() + fault.slot * lanes;
+    unsigned int stem = ffr_stem[fault.slot];
+    const unsigned long long* good_stem = good_values.get() + stem * lanes;
+    unsigned long long* faulty_stem = faulty_values.get() + stem * lanes;
+
+    // change at the FFR stem caused by the fault
+    bool active = false;
+    for (int l = 0; l < num_words; ++l) {
+        unsigned long long value;
+        if (fault.mod == FLIP) {
+            value = ~good[l];
+        } else if (fault.mod == STUCK0) {
+            value = 0;
+        } else {
+            value = ~((unsigned long long)(0));
+        }
+        unsigned long long diff = (value ^ good[l]) & obs[l];
+        faulty_stem[l] = good_stem[l] ^ diff;
+        active = active || (diff != 0);
+    }
+
+    if (!active) {
+        return false;
+    }
+    if (observed[stem]) {
+        for (int l = 0; l < num_words; ++l) {
+            faulty_stem[l] = good_stem[l];
+        }
+        return true;
+    }
+    return propagate(stem);
+}
+
+bool FaultSim::propagate(unsigned int stem)
+{
+    changed_slots.push_back(stem);
+    schedule_fanouts(stem);
+
+    // evaluate the changed part of the fanout cone level by level
+    bool found = false;
+    for (int level = 0; level < int(levels.size()); ++level) {
+        for (unsigned int k = 0; k < levels[level].size(); ++k) {
+            unsigned int id = levels[level][k];
+            scheduled[id] = false;
+            --num_scheduled;
+            if (found) {
+                continue;
+            }
+
+            program.run(faulty_values.get(), lane_sims, id, id + 1);
+            unsigned int out = program.get_op(id).out;
+            const unsigned long long* good_out = good_values.get() + out * lanes;
+            const unsigned long long* faulty_out = faulty_values.get() + out * lanes;
+            bool changed = false;
+            for (int l = 0; l < lanes; ++l) {
+                changed = changed || (faulty_out[l] != good_out[l]);
+            }
+            if (changed) {
+                changed_slots.push_back(out);
+                if (observed[out]) {
+                    found = true;
+                } else {
+                    schedule_fanouts(out);
+                }
+            }
+        }
+        levels[level].clear();
+    }
+
+    for (int i = 0; i < int(changed_slots.size()); ++i) {
+        unsigned int slot = changed_slots[i];
+        memcpy(faulty_values.get() + slot * lanes, good_values.get() + slot * lanes,
+                lanes * sizeof(unsigned long long));
+    }
+    changed_slots.clear();
+    return found;
+}
+
+void FaultSim::schedule_fanouts(unsigned int slot)
+{
+    for (const unsigned int* iter = program.fanout_begin(slot);
+            iter != program.fanout_end(slot); ++iter) {
+        if (!scheduled[*iter]) {
+            scheduled[*iter] = true;
+            ++num_scheduled;
+            levels[program.get_op_level(*iter)].push_back(*iter);
+        }
+    }
+}
+
+void FaultSim::load_observability(const SimValues& source_values, int word)
+{
+    if (post_dom.empty()) {
+        build_post_dominators();
+        observability.assign(program.num_slots() * lanes);
+    }
+
+    int num_sig_words = input_vectors.empty() ? 0 : input_vectors[0].size();
+    load_good_values(source_values, word, std::min(lanes, num_sig_words - word));
+    trace_ffrs();
+    for (int l = 0; l < lanes; ++l) {
+        lane_masks[l] = (lane_sims[l] >= int(SIGSTEP)) ? ~((unsigned long long)(0)) :
+            (((unsigned long long)(1) << lane_sims[l]) - 1);
+    }
+
+    // stems and post-dominators come after the slots they cover
+    for (int i = int(program.num_ops()) - 1; i >= 0; --i) {
+        unsigned int out = program.get_op(i).out;
+        unsigned long long* obs = observability.get() + out * lanes;
+        if (ffr_reader[out] == -1) {
+            trace_stem(out, obs);
+            continue;
+        }
+        const unsigned long long* path_obs = ffr_obs.get() + out * lanes;
+        const unsigned long long* stem_obs = get_observability(ffr_stem[out]);
+        for (int l = 0; l < lanes; ++l) {
+            obs[l] = path_obs[l] & stem_obs[l];
+        }
+    }
+}
+
+void FaultSim::build_post_dominators()
+{
+    unsigned int num_ops = program.num_ops();
+    slot_order.assign(program.num_slots(), num_ops);
+    for (unsigned int i = 0; i < num_ops; ++i) {
+        slot_order[program.get_op(i).out] = i;
+    }
+
+    // readers come after the operations they read
+    post_dom.assign(program.num_slots(), POST_DOM_NONE);
+    for (int i = int(num_ops) - 1; i >= 0; --i) {
+        unsigned int out = program.get_op(i).out;
+        unsigned int dom = observed[out] ? POST_DOM_SINK : POST_DOM_NONE;
+        for (const unsigned int* iter = program.fanout_begin(out);
+                iter != program.fanout_end(out); ++iter) {
+            unsigned int reader = program.get_op(*iter).out;
+            if (post_dom[reader] == POST_DOM_NONE) {
+                continue;
+            }
+            dom = (dom == POST_DOM_NONE) ? reader : intersect(dom, reader);
+        }
+        post_dom[out] = dom;
+    }
+}
+
+unsigned int FaultSim::intersect(unsigned int slot1, unsigned int slot2) const
+{
+    // move the earlier slot up its post-dominator chain until they meet
+    unsigned int num_ops = program.num_ops();
+    while (slot1 != slot2) {
+        unsigned int order1 = (slot1 == POST_DOM_SINK) ? num_ops : slot_order[slot1];
+        unsigned int order2 = (slot2 == POST_DOM_SINK) ? num_ops : slot_order[slot2];
+        if (order1 < order2) {
+            slot1 = post_dom[slot1];
+        } else {
+            slot2 = post_dom[slot2];
+        }
+    }
+    return slot1;
+}
+
+void FaultSim::trace_stem(unsigned int stem, unsigned long long* obs)
+{
+    unsigned int dom = post_dom[stem];
+    if (observed[stem] || (dom == POST_DOM_NONE)) {
+        for (int l = 0; l < lanes; ++l) {
+            obs[l] = observed[stem] ? lane_masks[l] : 0;
+        }
+        return;
+    }
+
+    const unsigned long long* good_stem = good_values.get() + stem * lanes;
+    unsigned long long* faulty_stem = faulty_values.get() + stem * lanes;
+    for (int l = 0; l < lanes; ++l) {
+        faulty_stem[l] = ~good_stem[l];
+        obs[l] = 0;
+    }
+    changed_slots.push_back(stem);
+    schedule_fanouts(stem);
+
+    // evaluate the changed part of the region up to the post-dominator;
+    // without one, every changed output counts until all patterns do
+    bool found = false;
+    int level = program.get_op_level(slot_order[stem]);
+    for (; num_scheduled > 0; ++level) {
+        for (unsigned int k = 0; k < levels[level].size(); ++k) {
+            unsigned int id = levels[level][k];
+            scheduled[id] = false;
+            --num_scheduled;
+            if (found) {
+                continue;
+            }
+
+            program.run(faulty_values.get(), lane_sims, id, id + 1);
+            unsigned int out = program.get_op(id).out;
+            const unsigned long long* good_out = good_values.get() + out * lanes;
+            const unsigned long long* faulty_out = faulty_values.get() + out * lanes;
+            bool changed = false;
+            for (int l = 0; l < lanes; ++l) {
+                changed = changed || (faulty_out[l] != good_out[l]);
+            }
+            if (!changed) {
+                continue;
+            }
+
+            changed_slots.push_back(out);
+            if (out == dom) {
+                const unsigned long long* dom_obs = get_observability(dom);
+                for (int l = 0; l < lanes; ++l) {
+                    obs[l] = (faulty_out[l] ^ good_out[l]) & dom_obs[l];
+                }
+                continue;
+            }
+            if (observed[out]) {
+                found = true;
+                for (int l = 0; l < lanes; ++l) {
+                    obs[l] |= faulty_out[l] ^ good_out[l];
+                    found = found && (obs[l] == lane_masks[l]);
+                }
+            }
+            schedule_fanouts(out);
+        }
+        levels[level].clear();
+    }
+
+    for (int i = 0; i < int(changed_slots.size()); ++i) {
+        unsigned int slot = changed_slots[i];
+        memcpy(faulty_values.get() + slot * lanes, good_values.get() + slot * lanes,
+                lanes * sizeof(unsigned long long));
+    }
+    changed_slots.clear();
+}
@@ -0,0 +1,145 @@
+#ifndef FAULTSIM_H
+#define FAULTSIM_H
+
+#include <vector>
+#include "Circuit.h"
+#include "SimProgram.h"
+
+/*!
+ * Parallel-pattern single-fault-propagation simulator for a set of
+ * input vectors.  The simulator owns all of its work space, so one
+ * object per thread can run on the same program concurrently.
+ *
+ * The circuit is split into fanout-free regions (FFRs).  Critical path
+ * tracing gives, for every gate in an FFR, the patterns where a change
+ * at the gate reaches the FFR stem.  A fault is then only propagated
+ * from its stem, through the gates of the stem's fanout cone whose
+ * values change.  Detected faults are dropped from later simulation
+ * words and structurally equivalent faults are simulated once.
+ *
+ * A fault is detected exactly when observable_signal() would return true.
+ *
+ * The same tracing gives the observability of every gate at once: a
+ * stem is flipped and propagated only up to its immediate
+ * post-dominator, whose observability is already known, so every
+ * reconvergence is resolved inside the region it spans.
+*/
+class FaultSim {
+  public:
+    /*!
+     * The vectors for input_slots[i] are input_vectors[i] (num_sims
+     * patterns packed SIGSTEP to a word).
+    */
+    FaultSim(const SimProgram& program_, const std::vector<unsigned int>& observed_slots,
+            const std::vector<unsigned int>& input_slots_,
+            const std::vector<std::vector<unsigned long long> >& input_vectors_,
+            int num_sims_);
+
+    /*!
+     * Set detected for every fault observable at the outputs.  Faults
+     * already marked detected are not simulated.  source_values holds
+     * the values of the other sources (e.g., keys) in every lane.
+    */
+    void run(std::vector<Fault>& faults, const SimValues& source_values);
+
+    /*!
+     * Simulate the words [word, word + lanes) and find for every gate
+     * output the patterns where flipping it changes an output (as
+     * observable_signal() checks with FLIP).
+    */
+    void load_observability(const SimValues& source_values, int word);
+
+    //! patterns of the loaded words where a flip at slot is observable
+    const unsigned long long* get_observability(unsigned int slot) const
+    {
+        return observability.get() + slot * lanes;
+    }
+
+    //! fault free values of the loaded words
+    const unsigned long long* get_good_values(unsigned int slot) const
+    {
+        return good_values.get() + slot * lanes;
+    }
+
+  private:
+    //! fault on a program slot (faults are collapsed to these)
+    struct SlotFault {
+        unsigned int slot;
+        ModType mod;
+    };
+
+    /*!
+     * Replace the fault by an equivalent fault further along its FFR
+     * (through gates whose output is forced by the faulty input).
+    */
+    void collapse(SlotFault& fault) const;
+
+    //! simulate the fault free circuit for words [word, word + lanes)
+    void load_good_values(const SimValues& source_values, int word, int num_words);
+
+    //! critical path tracing to the FFR stems for the loaded words
+    void trace_ffrs();
+
+    //! true if the fault changes an output in the loaded words
+    bool detect(const SlotFault& fault, int num_words);
+
+    //! propagate the value in faulty_values at stem through its fanout cone
+    bool propagate(unsigned int stem);
+
+    void schedule_fanouts(unsigned int slot);
+
+    //! immediate post-dominator of every gate output (see post_dom)
+    void build_post_dominators();
+
+    //! post-dominator of both slots that is closest to them
+    unsigned int intersect(unsigned int slot1, unsigned int slot2) const;
+
+    /*!
+     * Observability of a stem from the change that flipping it causes
+     * at its immediate post-dominator (or at the outputs).
+    */
+    void trace_stem(unsigned int stem, unsigned long long* obs);
+
+    const SimProgram& program;
+    const std::vector<unsigned int>& input_slots;
+    const std::vector<std::vector<unsigned long long> >& input_vectors;
+    int num_sims;
+    int lanes;
+
+    std::vector<bool> observed;
+
+    //! operation reading the slot if the slot is inside an FFR (-1 for stems)
+    std::vector<int> ffr_reader;
+
+    //! stem of the FFR containing the slot
+    std::vector<unsigned int> ffr_stem;
+
+    //! patterns where a change at the slot changes its FFR stem
+    SimValues ffr_obs;
+
+    /*!
+     * Immediate post-dominator of each gate output, with the outputs
+     * all reaching a common sink (POST_DOM_SINK if only the sink
+     * dominates, POST_DOM_NONE if no output is reached).  Built on the
+     * first call to load_observability().
+    */
+    std::vector<unsigned int> post_dom;
+
+    //! position of the operation computing each slot
+    std::vector<unsigned int> slot_order;
+
+    //! patterns where a change at the slot changes an output
+    SimValues observability;
+    unsigned long long lane_masks[SimProgram::MAX_LANES];
+
+    SimValues good_values;
+    SimValues faulty_values;
+    int lane_sims[SimProgram::MAX_LANES];
+
+    std::vector<bool> scheduled;
+    unsigned int num_scheduled;
+    std::vector<std::vector<unsigned int> > levels;
+    std::vector<unsigned int> changed_slots;
+};
+
+#endif
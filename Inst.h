@@ -7,30 +7,29 @@
 
 class Port;
 
+/*!
+ * Instances are created by a Netlist, which also holds their pins and
+ * cells.
+*/
 class Inst : public CircuitElement {
   public:
-    Inst(std::string name_, bool is_port_ = false, bool is_latch_ = false) : 
-        CircuitElement(name_), is_port(is_port_), is_latch(is_latch_), level(0) {}
-
-    CircuitElementType get_type() const
-    {
-        return INST;
-    }
+    Inst(unsigned int name_id_, Netlist* netlist_, unsigned int id_, bool is_port_ = false,
+            bool is_latch_ = false) :
+        CircuitElement(name_id_, netlist_, INST, id_), is_port(is_port_),
+        is_latch(is_latch_), level(0) {}
 
     void add_input(Port* in_port)
     {
-        inputs.push_back(in_port);
+        netlist->pins.push_back(inputs, in_port);
     }
     void add_output(Port* in_port)
     {
-        outputs.push_back(in_port);
+        netlist->pins.push_back(outputs, in_port);
     }
 
-    void evaluate(int num_simulations);
-
     void add_lib_cell(lib_cell* lib_cell_)
     {
-        lib_cells.push_back(lib_cell_);
+        netlist->cells.push_back(lib_cells, lib_cell_);
     } 
 
     bool get_is_port() const
@@ -44,7 +43,7 @@ class Inst : public CircuitElement {
 
     unsigned int num_outputs() const
     {
-        return outputs.size();
+        return outputs.size;
     }
 
     void set_level(int level_)
@@ -59,57 +58,74 @@ class Inst : public CircuitElement {
 
     unsigned int num_inputs() const
     {
-        return inputs.size();
+        return inputs.size;
     }   
 
     Port * get_output(unsigned int id)
     {
-        return outputs[id];
+        return netlist->pins.at(outputs, id);
     }
     Port * get_input(unsigned int id)
     {
-        return inputs[id];
+        return netlist->pins.at(inputs, id);
     }
 
     bool is_PI()
     {
-        return (is_port && inputs.empty());
+        return (is_port && (inputs.size == 0));
     }
 
-    typedef std::vector<Port*>::iterator output_iterator;
-    typedef std::vector<Port*>::iterator input_iterator;
+    //! invalidated when a pin list grows
+    typedef Port** output_iterator;
+    typedef Port** input_iterator;
 
     output_iterator output_begin()
     {
-       return output_iterator(outputs.begin()); 
+       return netlist->pins.begin(outputs);
     }
     output_iterator output_end()
     {
-       return output_iterator(outputs.end()); 
+       return netlist->pins.end(outputs);
     }
 
     input_iterator input_begin()
     {
-       return input_iterator(inputs.begin()); 
+       return netlist->pins.begin(inputs);
     }
     input_iterator input_end()
     {
-       return input_iterator(inputs.end()); 
+       return netlist->pins.end(inputs);
     }
 
     lib_cell* get_libcell(unsigned int id)
     {
-        return lib_cells[id];
+        return netlist->cells.at(lib_cells, id);
+    }
+    unsigned int num_lib_cells() const
+    {
+        return lib_cells.size;
+    }
+
+    //! lists in the netlist (for compaction)
+    ListRange& get_input_list()
+    {
+        return inputs;
+    }
+    ListRange& get_output_list()
+    {
+        return outputs;
+    }
+    ListRange& get_cell_list()
+    {
+        return lib_cells;
     }
 
   private:
-    void evaluate_core(int num_simulations);
-    
-    std::vector<Port*> inputs;
-    std::vector<Port*> outputs;
+    ListRange inputs;
+    ListRange outputs;
 
-    //! vector of single output library function (corresponds to outputs)
-    std::vector<lib_cell*> lib_cells;
+    //! single output library functions (corresponds to outputs)
+    ListRange lib_cells;
    
     bool is_port;
     bool is_latch;
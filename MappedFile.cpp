@@ -0,0 +1,50 @@
+#include "MappedFile.h"
+#include "utils.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+
+using std::string;
+
+MappedFile::MappedFile(const string& filename) : data(0), size(0), mapping(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw Error("Cannot open file");
+    }
+    struct stat info;
+    if ((fstat(fd, &info) == 0) && S_ISREG(info.st_mode) && (info.st_size > 0)) {
+        void* addr = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            madvise(addr, info.st_size, MADV_SEQUENTIAL);
+            mapping = addr;
+            size = info.st_size;
+            data = (const char*)(addr);
+        }
+    }
+    close(fd);
+
+    // not a mappable file: read it into memory
+    if (!mapping) {
+        std::ifstream fin(filename.c_str(), std::ios::binary);
+        if (!fin) {
+            throw Error("Cannot open file");
+        }
+        std::stringstream buffer;
+        buffer << fin.rdbuf();
+        contents = buffer.str();
+        data = contents.data();
+        size = contents.size();
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (mapping) {
+        munmap(mapping, size);
+    }
+}
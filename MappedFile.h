@@ -0,0 +1,39 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+/*!
+ * Read-only view of a whole file.  Regular files are memory mapped;
+ * anything else (e.g., a pipe) is read into memory.
+*/
+class MappedFile {
+  public:
+    /*!
+     * Throws an Error if the file cannot be opened.
+    */
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    const char* begin() const
+    {
+        return data;
+    }
+
+    const char* end() const
+    {
+        return data + size;
+    }
+
+  private:
+    //! not copyable (owns the mapping)
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* data;
+    std::size_t size;
+    void* mapping;
+    std::string contents;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "NameTable.h"
+
+#include <boost/functional/hash.hpp>
+
+using std::string;
+using std::vector;
+using boost::string_ref;
+
+const unsigned int NameTable::NONE;
+
+unsigned int NameTable::intern(string_ref name)
+{
+    std::size_t slot = lookup(name);
+    if (slots[slot] != NONE) {
+        return slots[slot];
+    }
+    unsigned int id = names.size();
+    names.push_back(string(name.data(), name.size()));
+    slots[slot] = id;
+
+    // keep the index at most half full
+    if (2 * names.size() > slots.size()) {
+        grow();
+    }
+    return id;
+}
+
+unsigned int NameTable::find(string_ref name) const
+{
+    return slots[lookup(name)];
+}
+
+std::size_t NameTable::lookup(string_ref name) const
+{
+    std::size_t mask = slots.size() - 1;
+    std::size_t slot = boost::hash_range(name.begin(), name.end()) & mask;
+    while (slots[slot] != NONE) {
+        const string& entry = names[slots[slot]];
+        if ((entry.size() == name.size()) && (name.compare(entry) == 0)) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void NameTable::grow()
+{
+    slots.assign(2 * slots.size(), NONE);
+    std::size_t mask = slots.size() - 1;
+    for (unsigned int id = 0; id < names.size(); ++id) {
+        const string& name = names[id];
+        std::size_t slot = boost::hash_range(name.begin(), name.end()) & mask;
+        while (slots[slot] != NONE) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = id;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+
+/*!
+ * Interns names: every distinct name is stored once and gets a
+ * symbol id (0, 1, ... in order of first use).  Ids and references
+ * to the stored names stay valid for the life of the table.
+*/
+class NameTable {
+  public:
+    //! id returned by find() for an unknown name
+    static const unsigned int NONE = ~0u;
+
+    NameTable() : slots(16, NONE) {}
+
+    //! id of the name, adding it if needed
+    unsigned int intern(boost::string_ref name);
+
+    //! id of the name or NONE
+    unsigned int find(boost::string_ref name) const;
+
+    const std::string& get(unsigned int id) const
+    {
+        return names[id];
+    }
+
+    unsigned int size() const
+    {
+        return names.size();
+    }
+
+  private:
+    //! slot of the name, or the empty slot where it belongs
+    std::size_t lookup(boost::string_ref name) const;
+    void grow();
+
+    std::deque<std::string> names;
+
+    //! open addressing index of names (NONE marks an empty slot)
+    std::vector<unsigned int> slots;
+};
+
+#endif
@@ -0,0 +1,351 @@
+#include "NativeSim.h"
+#include "SimProgram.h"
+#include "TechLibrary.h"
+#include "utils.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <tr1/unordered_map>
+#include <boost/functional/hash.hpp>
+
+using std::string;
+using std::vector;
+using std::stringstream;
+using std::ofstream;
+using std::cout; using std::endl;
+using std::tr1::unordered_map;
+
+string NativeSim::cache_dir;
+
+void NativeSim::set_cache_dir(string cache_dir_)
+{
+    cache_dir = cache_dir_;
+
+    // create the directory and any missing parents
+    for (string::size_type pos = 1; pos <= cache_dir.size(); ++pos) {
+        if ((pos < cache_dir.size()) && (cache_dir[pos] != '/')) {
+            continue;
+        }
+        string dir = cache_dir.substr(0, pos);
+        if ((mkdir(dir.c_str(), 0777) != 0) && (errno != EEXIST)) {
+            throw Error("Cannot create native simulator directory " + dir);
+        }
+    }
+    struct stat dir_stat;
+    if (!cache_dir.empty() && ((stat(cache_dir.c_str(), &dir_stat) != 0) ||
+                !S_ISDIR(dir_stat.st_mode))) {
+        throw Error("Native simulator path is not a directory: " + cache_dir);
+    }
+}
+
+// operations per generated function (keeps compile time linear)
+static const unsigned int OPS_PER_PART = 512;
+
+// expression loading a slot value
+static string slot_value(unsigned int slot)
+{
+    stringstream value;
+    value << "LD(" << slot << ")";
+    return value.str();
+}
+
+string NativeSim::generate_source(const SimProgram& program)
+{
+    int lanes = program.get_lanes();
+    stringstream src;
+    src << "// generated by CircuitLock: " << program.num_ops() << " operations, "
+        << lanes << " lanes\n";
+    src << "#include <stdint.h>\n";
+    if (lanes == 1) {
+        src << "typedef uint64_t Word;\n";
+    } else {
+        src << "typedef uint64_t Word __attribute__((vector_size(" << lanes * 8 << ")));\n";
+    }
+    src << "#define LD(s) (*(const Word*)(values + (s) * " << lanes << "))\n";
+    src << "#define ST(s, v) (*(Word*)(values + (s) * " << lanes << ") = (v))\n";
+
+    // each op loads its fanins and stores its (masked) output
+    unsigned int num_parts = 0;
+    for (unsigned int i = 0; i < program.num_ops(); ++i) {
+        if ((i % OPS_PER_PART) == 0) {
+            if (i > 0) {
+                src << "}\n";
+            }
+            src << "static void __attribute__((noinline)) part" << num_parts++
+                << "(uint64_t* __restrict values, Word mask)\n{\n";
+            src << "    const Word zero = mask ^ mask;\n";
+            src << "    const Word ones = ~zero;\n";
+            src << "    (void)ones;\n";
+        }
+
+        const SimOp& op = program.get_op(i);
+        const unsigned int* in = program.op_fanins(op);
+        vector<string> ins;
+        for (unsigned int j = 0; j < op.num_inputs; ++j) {
+            ins.push_back(slot_value(in[j]));
+        }
+
+        stringstream expr;
+        src << "    {\n";
+        switch (op.code) {
+            case SIM_BUF: expr << ins[0]; break;
+            case SIM_NOT: expr << "~" << ins[0]; break;
+            case SIM_AND: expr << ins[0] << " & " << ins[1]; break;
+            case SIM_OR: expr << ins[0] << " | " << ins[1]; break;
+            case SIM_XOR: expr << ins[0] << " ^ " << ins[1]; break;
+            case SIM_XNOR: expr << ins[0] << " ^ ~" << ins[1]; break;
+            case SIM_NAND: expr << "~(" << ins[0] << " & " << ins[1] << ")"; break;
+            case SIM_NOR: expr << "~(" << ins[0] << " | " << ins[1] << ")"; break;
+            case SIM_NANDL: expr << "~(~" << ins[0] << " & " << ins[1] << ")"; break;
+            case SIM_NANDR: expr << "~(" << ins[0] << " & ~" << ins[1] << ")"; break;
+            case SIM_NORL: expr << ins[0] << " & ~" << ins[1]; break;
+            case SIM_NORR: expr << "~" << ins[0] << " & " << ins[1]; break;
+            case SIM_MUX:
+                expr << "(~" << ins[2] << " & " << ins[0] << ") | ("
+                    << ins[2] << " & " << ins[1] << ")";
+                break;
+            case SIM_CELL:
+                {
+                    // kernel registers become locals k<reg>
+                    vector<string> regs;
+                    regs.push_back("zero");
+                    regs.push_back("ones");
+                    for (unsigned int j = 0; j < op.num_inputs; ++j) {
+                        stringstream reg;
+                        reg << "k" << regs.size();
+                        src << "        const Word " << reg.str() << " = " << ins[j] << ";\n";
+                        regs.push_back(reg.str());
+                    }
+                    const vector<CellOp>& kernel = op.cell->get_kernel();
+                    for (unsigned int k = 0; k < kernel.size(); ++k) {
+                        const CellOp& kop = kernel[k];
+                        stringstream reg;
+                        reg << "k" << regs.size();
+                        src << "        const Word " << reg.str() << " = ";
+                        switch (kop.code) {
+                            case CellOp::AND: src << regs[kop.a] << " & " << regs[kop.b]; break;
+                            case CellOp::OR: src << regs[kop.a] << " | " << regs[kop.b]; break;
+                            case CellOp::XOR: src << regs[kop.a] << " ^ " << regs[kop.b]; break;
+                            case CellOp::ANDN: src << regs[kop.a] << " & ~" << regs[kop.b]; break;
+                            case CellOp::ORN: src << regs[kop.a] << " | ~" << regs[kop.b]; break;
+                            default:
+                                src << "(" << regs[kop.c] << " & " << regs[kop.a] << ") | (~"
+                                    << regs[kop.c] << " & " << regs[kop.b] << ")";
+                                break;
+                        }
+                        src << ";\n";
+                        regs.push_back(reg.str());
+                    }
+                    expr << regs[op.cell->get_kernel_out()];
+                    break;
+                }
+            default:
+                {
+                    // first matching cube decides the output
+                    src << "        Word res = zero;\n";
+                    src << "        Word rem = ones;\n";
+                    const lib_cell* cell = op.cell;
+                    for (int c = 0; c < cell->num_cubes(); ++c) {
+                        src << "        {\n            const Word match = rem";
+                        for (const unsigned int* lit = cell->cube_begin(c);
+                                lit != cell->cube_end(c); ++lit) {
+                            src << " & " << ((*lit & 1) ? "" : "~") << ins[*lit >> 1];
+                        }
+                        src << ";\n";
+                        if (cell->get_cube_output(c)) {
+                            src << "            res |= match;\n";
+                        }
+                        src << "            rem &= ~match;\n        }\n";
+                    }
+                    if (cell->get_cover_default()) {
+                        src << "        res |= rem;\n";
+                    }
+                    expr << "res";
+                    break;
+                }
+        }
+        src << "        ST(" << op.out << ", (" << expr.str() << ") & mask);\n    }\n";
+    }
+    if (num_parts > 0) {
+        src << "}\n";
+    }
+
+    src << "extern \"C\" void circuitlock_sim(uint64_t* values, const uint64_t* masks)\n{\n";
+    src << "    Word mask;\n";
+    src << "    __builtin_memcpy(&mask, masks, sizeof(Word));\n";
+    for (unsigned int p = 0; p < num_parts; ++p) {
+        src << "    part" << p << "(values, mask);\n";
+    }
+    src << "}\n";
+    return src.str();
+}
+
+// compiler command (CXX may hold a launcher and arguments) and flags
+static vector<string> compiler_command()
+{
+    vector<string> args;
+    const char* cxx = getenv("CXX");
+    stringstream words(cxx ? cxx : "c++");
+    string word;
+    while (words >> word) {
+        args.push_back(word);
+    }
+    if (args.empty()) {
+        args.push_back("c++");
+    }
+    args.push_back("-O1");
+    args.push_back("-march=native");
+    args.push_back("-shared");
+    args.push_back("-fPIC");
+    args.push_back("-w");
+    return args;
+}
+
+// instruction set extensions of the host (-march=native depends on them)
+static string host_cpu_features()
+{
+    std::ifstream fin("/proc/cpuinfo");
+    string line;
+    while (std::getline(fin, line)) {
+        if ((line.compare(0, 5, "flags") == 0) || (line.compare(0, 8, "Features") == 0)) {
+            return line;
+        }
+    }
+
+    string features;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    // __builtin_cpu_supports only takes literals
+#define CPU_FEATURE(name) features += string(name) + (__builtin_cpu_supports(name) ? "+" : "-")
+    __builtin_cpu_init();
+    CPU_FEATURE("sse4.2");
+    CPU_FEATURE("popcnt");
+    CPU_FEATURE("avx");
+    CPU_FEATURE("avx2");
+    CPU_FEATURE("bmi");
+    CPU_FEATURE("bmi2");
+    CPU_FEATURE("fma");
+    CPU_FEATURE("avx512f");
+    CPU_FEATURE("avx512bw");
+    CPU_FEATURE("avx512dq");
+    CPU_FEATURE("avx512vl");
+#undef CPU_FEATURE
+#endif
+    return features;
+}
+
+// run the command without a shell; true if it exits with status 0
+static bool run_command(const vector<string>& args)
+{
+    vector<char*> argv;
+    for (unsigned int i = 0; i < args.size(); ++i) {
+        argv.push_back(const_cast<char*>(args[i].c_str()));
+    }
+    argv.push_back(0);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, 1);
+            dup2(null_fd, 2);
+        }
+        execvp(argv[0], &argv[0]);
+        _exit(127);
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+// the interpreter is used for programs that cannot be built; only the
+// first failure is reported
+static void fallback_warning(const string& msg)
+{
+    static bool warned = false;
+    if (!warned) {
+        cout << msg << "; using interpreter" << endl;
+        warned = true;
+    }
+}
+
+NativeSimFunc NativeSim::load(const SimProgram& program)
+{
+    if (!enabled() || (program.num_ops() == 0)) {
+        return 0;
+    }
+
+    // already loaded (or failed to build, stored as 0) in this process;
+    // objects built by another compiler or for another CPU are not reused
+    static unordered_map<string, NativeSimFunc> loaded;
+    static vector<string> compiler = compiler_command();
+    static string cpu_features = host_cpu_features();
+    string source = generate_source(program);
+    std::size_t key = boost::hash_value(source);
+    boost::hash_combine(key, compiler);
+    boost::hash_combine(key, cpu_features);
+    stringstream base;
+    base << cache_dir << "/circuitlock_" << std::hex << key;
+    string so_file = base.str() + ".so";
+    if (loaded.find(so_file) != loaded.end()) {
+        return loaded[so_file];
+    }
+
+    void* handle = dlopen(so_file.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        string cpp_file = base.str() + ".cpp";
+        ofstream fout(cpp_file.c_str());
+        fout << source;
+        fout.close();
+        if (!fout) {
+            fallback_warning("Cannot write native simulator source");
+            loaded[so_file] = 0;
+            return 0;
+        }
+
+        // build under a temporary name so other processes never see a partial file
+        stringstream tmp_file;
+        tmp_file << so_file << ".tmp" << getpid();
+        vector<string> command = compiler;
+        command.push_back("-o");
+        command.push_back(tmp_file.str());
+        command.push_back(cpp_file);
+        if (!run_command(command) ||
+                (rename(tmp_file.str().c_str(), so_file.c_str()) != 0)) {
+            remove(tmp_file.str().c_str());
+            fallback_warning("Cannot compile native simulator");
+            loaded[so_file] = 0;
+            return 0;
+        }
+        handle = dlopen(so_file.c_str(), RTLD_NOW | RTLD_LOCAL);
+    }
+
+    NativeSimFunc func = 0;
+    if (handle) {
+        func = (NativeSimFunc)(dlsym(handle, "circuitlock_sim"));
+    }
+    if (!func) {
+        fallback_warning("Cannot load native simulator");
+        loaded[so_file] = 0;
+        return 0;
+    }
+    loaded[so_file] = func;
+    return func;
+}
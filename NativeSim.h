@@ -0,0 +1,46 @@
+#ifndef NATIVESIM_H
+#define NATIVESIM_H
+
+#include <string>
+
+class SimProgram;
+
+//! native simulation pass: values and masks are laid out as in SimProgram::run
+typedef void (*NativeSimFunc)(unsigned long long* values, const unsigned long long* masks);
+
+/*!
+ * Translates a SimProgram into straight-line C++ (one statement per
+ * operation, values kept in local variables), compiles it with the
+ * system compiler into a shared object, and loads it.  Shared objects
+ * are cached by a hash of the generated source, the compiler command
+ * and the CPU features of the host, so a netlist is only compiled once
+ * per cache directory and host type.
+*/
+class NativeSim {
+  public:
+    /*!
+     * Enable native simulation with shared objects kept in cache_dir
+     * (an empty string disables it).  The directory and any missing
+     * parents are created; an Error is thrown if that fails.  The
+     * compiler is taken from the CXX environment variable (default c++).
+    */
+    static void set_cache_dir(std::string cache_dir_);
+
+    static bool enabled()
+    {
+        return !cache_dir.empty();
+    }
+
+    /*!
+     * Returns the native function for the whole program, or 0 if it
+     * cannot be built (the interpreter should be used instead).
+    */
+    static NativeSimFunc load(const SimProgram& program);
+
+  private:
+    static std::string generate_source(const SimProgram& program);
+
+    static std::string cache_dir;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "Netlist.h"
+#include "Wire.h"
+#include "Inst.h"
+#include "Port.h"
+
+using std::string;
+using std::vector;
+using boost::string_ref;
+
+// out of line: the pools need the complete element types
+Netlist::Netlist()
+{
+}
+
+Netlist::~Netlist()
+{
+}
+
+Wire* Netlist::create_wire(string_ref name)
+{
+    Wire* wire = new (wires.next()) Wire(names.intern(name), this, wires.size());
+    wires.add();
+    return wire;
+}
+
+Inst* Netlist::create_inst(string_ref name, bool is_port, bool is_latch)
+{
+    Inst* inst = new (insts.next()) Inst(names.intern(name), this, insts.size(),
+            is_port, is_latch);
+    insts.add();
+    return inst;
+}
+
+Port* Netlist::create_port(string_ref name)
+{
+    Port* port = new (ports.next()) Port(names.intern(name), this, ports.size());
+    ports.add();
+    return port;
+}
+
+Wire* Netlist::get_wire(unsigned int id) const
+{
+    return wires[id];
+}
+
+Inst* Netlist::get_inst(unsigned int id) const
+{
+    return insts[id];
+}
+
+Port* Netlist::get_port(unsigned int id) const
+{
+    return ports[id];
+}
+
+void Netlist::compact()
+{
+    // lists in id order, so connected elements stay close
+    vector<ListRange*> pin_lists, fanout_lists, cell_lists;
+    pin_lists.reserve(2 * insts.size());
+    cell_lists.reserve(insts.size());
+    for (unsigned int i = 0; i < insts.size(); ++i) {
+        pin_lists.push_back(&(insts[i]->get_input_list()));
+        pin_lists.push_back(&(insts[i]->get_output_list()));
+        cell_lists.push_back(&(insts[i]->get_cell_list()));
+    }
+    fanout_lists.reserve(wires.size());
+    for (unsigned int i = 0; i < wires.size(); ++i) {
+        fanout_lists.push_back(&(wires[i]->get_output_list()));
+    }
+    pins.compact(pin_lists);
+    fanouts.compact(fanout_lists);
+    cells.compact(cell_lists);
+}
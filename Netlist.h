@@ -0,0 +1,232 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <string>
+#include <vector>
+#include <new>
+#include <algorithm>
+#include <boost/utility/string_ref.hpp>
+#include "NameTable.h"
+
+class Wire;
+class Inst;
+class Port;
+class lib_cell;
+
+//! position of one list in a ListStore
+struct ListRange {
+    ListRange() : begin(0), size(0), capacity(0) {}
+    unsigned int begin;
+    unsigned int size;
+    unsigned int capacity;
+};
+
+/*!
+ * Lists of many elements in one array (CSR layout): a list is the
+ * range [begin, begin + size) and has room for capacity entries.  A
+ * full list grows in place if it is the last one in the array and is
+ * otherwise moved to the end with twice the room; compact() drops
+ * the room that is left behind.  Pointers to entries are invalidated
+ * when any list grows.
+*/
+template <class T>
+class ListStore {
+  public:
+    T* begin(const ListRange& list)
+    {
+        return entries.empty() ? 0 : &entries[0] + list.begin;
+    }
+
+    T* end(const ListRange& list)
+    {
+        return begin(list) + list.size;
+    }
+
+    T& at(const ListRange& list, unsigned int i)
+    {
+        return entries[list.begin + i];
+    }
+
+    void push_back(ListRange& list, T value)
+    {
+        if (list.size == list.capacity) {
+            grow(list);
+        }
+        entries[list.begin + list.size++] = value;
+    }
+
+    //! replace the entries of a list (moved to the end if it has no room)
+    void assign(ListRange& list, const T* first, const T* last)
+    {
+        unsigned int size = last - first;
+        if (size > list.capacity) {
+            list.begin = entries.size();
+            list.capacity = size;
+            entries.resize(entries.size() + size);
+        }
+        std::copy(first, last, entries.begin() + list.begin);
+        list.size = size;
+    }
+
+    //! number of entries including unused room
+    std::size_t capacity() const
+    {
+        return entries.size();
+    }
+
+    /*!
+     * Pack the given lists in order without room to spare.  The lists
+     * must include every list of the store.
+    */
+    void compact(const std::vector<ListRange*>& lists)
+    {
+        std::vector<T> packed;
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < lists.size(); ++i) {
+            total += lists[i]->size;
+        }
+        packed.reserve(total);
+        for (std::size_t i = 0; i < lists.size(); ++i) {
+            ListRange& list = *lists[i];
+            unsigned int begin = packed.size();
+            packed.insert(packed.end(), entries.begin() + list.begin,
+                    entries.begin() + list.begin + list.size);
+            list.begin = begin;
+            list.capacity = list.size;
+        }
+        entries.swap(packed);
+    }
+
+  private:
+    void grow(ListRange& list)
+    {
+        unsigned int capacity = list.capacity ? 2 * list.capacity : 1;
+        if (list.begin + list.capacity == entries.size()) {
+            entries.resize(list.begin + capacity);
+        } else {
+            unsigned int begin = entries.size();
+            entries.resize(begin + capacity);
+            for (unsigned int i = 0; i < list.size; ++i) {
+                entries[begin + i] = entries[list.begin + i];
+            }
+            list.begin = begin;
+        }
+        list.capacity = capacity;
+    }
+
+    std::vector<T> entries;
+};
+
+/*!
+ * Owns elements of one type in fixed-size chunks, so elements never
+ * move.  The id of an element is its position in the pool.  Elements
+ * are destroyed with the pool.
+*/
+template <class T>
+class ElementPool {
+  public:
+    ElementPool() : num_elements(0) {}
+
+    ~ElementPool()
+    {
+        for (unsigned int i = 0; i < num_elements; ++i) {
+            (*this)[i]->~T();
+        }
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            ::operator delete(chunks[i]);
+        }
+    }
+
+    T* operator[](unsigned int id) const
+    {
+        return chunks[id >> CHUNK_BITS] + (id & (CHUNK_SIZE - 1));
+    }
+
+    unsigned int size() const
+    {
+        return num_elements;
+    }
+
+    //! memory for the element with id size() (see add())
+    void* next()
+    {
+        if ((num_elements >> CHUNK_BITS) == chunks.size()) {
+            chunks.push_back(static_cast<T*>(::operator new(CHUNK_SIZE * sizeof(T))));
+        }
+        return (*this)[num_elements];
+    }
+
+    //! count the element constructed in next()
+    void add()
+    {
+        ++num_elements;
+    }
+
+  private:
+    //! not copyable (owns the elements)
+    ElementPool(const ElementPool&);
+    ElementPool& operator=(const ElementPool&);
+
+    static const unsigned int CHUNK_BITS = 10;
+    static const unsigned int CHUNK_SIZE = 1 << CHUNK_BITS;
+
+    std::vector<T*> chunks;
+    unsigned int num_elements;
+};
+
+/*!
+ * Elements of a circuit and their connections.  Wires, instances and
+ * ports are numbered densely per type in order of creation.  The pins
+ * of an instance (inputs and outputs), the fanout of a wire and the
+ * cells of an instance are lists in shared CSR arrays.  The names of
+ * all elements are interned in one table.  Everything is released
+ * with the netlist.
+*/
+class Netlist {
+  public:
+    Netlist();
+    ~Netlist();
+
+    Wire* create_wire(boost::string_ref name);
+    Inst* create_inst(boost::string_ref name, bool is_port = false, bool is_latch = false);
+    Port* create_port(boost::string_ref name);
+
+    Wire* get_wire(unsigned int id) const;
+    Inst* get_inst(unsigned int id) const;
+    Port* get_port(unsigned int id) const;
+
+    unsigned int num_wires() const
+    {
+        return wires.size();
+    }
+    unsigned int num_insts() const
+    {
+        return insts.size();
+    }
+    unsigned int num_ports() const
+    {
+        return ports.size();
+    }
+
+    //! drop the unused room in the connection lists
+    void compact();
+
+    //! names of the elements
+    NameTable names;
+
+    //! inputs and outputs of instances
+    ListStore<Port*> pins;
+    //! ports read by each wire
+    ListStore<Port*> fanouts;
+    ListStore<lib_cell*> cells;
+
+  private:
+    Netlist(const Netlist&);
+    Netlist& operator=(const Netlist&);
+
+    ElementPool<Wire> wires;
+    ElementPool<Inst> insts;
+    ElementPool<Port> ports;
+};
+
+#endif
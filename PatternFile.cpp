@@ -0,0 +1,311 @@
+#include "PatternFile.h"
+#include "utils.h"
+
+#include <cstring>
+#include <cctype>
+#include <fstream>
+#include <algorithm>
+#include <stdint.h>
+#include <tr1/unordered_map>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using std::string;
+using std::vector;
+using std::tr1::unordered_map;
+
+//! first bytes of a packed pattern file
+const char PATTERN_MAGIC[8] = { 'C', 'L', 'P', 'A', 'T', '\r', '\n', '\0' };
+const uint32_t PATTERN_VERSION = 1;
+const uint32_t PATTERN_BYTE_ORDER = 0x01020304;
+
+struct PatternHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t num_inputs;
+    uint32_t num_patterns;
+    uint32_t words_per_input;
+    uint32_t reserved;
+};
+
+typedef unordered_map<string, vector<int> > InputMap;
+
+// every input of each name (in input order)
+static void map_inputs(const vector<string>& input_names, InputMap& inputs)
+{
+    for (int i = 0; i < int(input_names.size()); ++i) {
+        inputs[input_names[i]].push_back(i);
+    }
+}
+
+// same characters as the stream extraction operators skip
+static bool is_space(char chr)
+{
+    return isspace((unsigned char)(chr));
+}
+
+// bit i is set if chars[i] is '1' (reads 64 characters)
+static inline unsigned long long pack_row(const char* chars, int len)
+{
+    unsigned long long bits = 0;
+#ifdef __SSE2__
+    const __m128i ones = _mm_set1_epi8('1');
+    for (int i = 0; i < 4; ++i) {
+        __m128i vals = _mm_loadu_si128((const __m128i*)(chars + 16 * i));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(vals, ones));
+        bits |= (unsigned long long)(mask) << (16 * i);
+    }
+#else
+    for (int i = 0; i < 64; ++i) {
+        bits |= (unsigned long long)(chars[i] == '1') << i;
+    }
+#endif
+    return (len < 64) ? (bits & ((1ULL << len) - 1)) : bits;
+}
+
+// transpose a 64x64 bit matrix (bit c of rows[r] moves to bit r of
+// rows[c]) by swapping ever smaller off-diagonal blocks
+static void transpose64(unsigned long long* rows)
+{
+    unsigned long long mask = 0x00000000ffffffffULL;
+    for (int width = 32; width != 0; width >>= 1, mask ^= (mask << width)) {
+        for (int k = 0; k < 64; k = ((k | width) + 1) & ~width) {
+            unsigned long long swap = ((rows[k] >> width) ^ rows[k | width]) & mask;
+            rows[k] ^= swap << width;
+            rows[k | width] ^= swap;
+        }
+    }
+}
+
+PatternReader::PatternReader(const string& filename) : file(filename)
+{
+}
+
+int PatternReader::read(const vector<string>& input_names,
+        vector<vector<unsigned long long> >& words)
+{
+    if ((file.end() - file.begin() >= int(sizeof(PATTERN_MAGIC))) &&
+            (memcmp(file.begin(), PATTERN_MAGIC, sizeof(PATTERN_MAGIC)) == 0)) {
+        return read_binary(input_names, words);
+    }
+    return read_text(input_names, words);
+}
+
+int PatternReader::read_text(const vector<string>& input_names,
+        vector<vector<unsigned long long> >& words)
+{
+    const char* pos = file.begin();
+    const char* end = file.end();
+
+    InputMap inputs;
+    map_inputs(input_names, inputs);
+
+    // input of each value in a row
+    vector<int> row_inputs;
+    string name;
+    while (true) {
+        while ((pos != end) && is_space(*pos)) {
+            ++pos;
+        }
+        if (pos == end) {
+            break;
+        }
+        const char* name_end = pos;
+        while ((name_end != end) && !is_space(*name_end)) {
+            ++name_end;
+        }
+        name.assign(pos, name_end);
+        pos = name_end;
+
+        InputMap::iterator iter = inputs.find(name);
+        if (iter == inputs.end()) {
+            throw Error("Could not find test input: " + name + " in circuit" );
+        }
+        row_inputs.insert(row_inputs.end(), iter->second.begin(), iter->second.end());
+        if (row_inputs.size() == input_names.size()) {
+            break;
+        }
+    }
+    if (row_inputs.size() != input_names.size()) {
+        throw Error("Test file is missing circuit inputs");
+    }
+
+    // 64 patterns at a time: the values are gathered without
+    // whitespace, packed into one bit row per pattern and 64 inputs per
+    // chunk, and each chunk is transposed into the words of its inputs
+    int row_size = row_inputs.size();
+    std::size_t block_size = 64 * std::size_t(row_size);
+    int num_chunks = (row_size + 63) / 64;
+    vector<char> block(block_size + 64);
+    vector<unsigned long long> matrix(64 * num_chunks);
+    unsigned long long num_values = 0;
+    for (int word = 0; ; ++word) {
+        std::size_t count = 0;
+        while ((count < block_size) && (pos != end)) {
+            char chr = *pos++;
+            if ((chr == '0') || (chr == '1')) {
+                block[count++] = chr;
+            } else if (!is_space(chr)) {
+                throw Error("Unrecognized value in test file");
+            }
+        }
+        if (count == 0) {
+            break;
+        }
+        std::fill(block.begin() + count, block.end(), '0');
+        num_values += count;
+
+        int num_rows = (count + row_size - 1) / row_size;
+        for (int chunk = 0; chunk < num_chunks; ++chunk) {
+            unsigned long long* rows = &matrix[64 * chunk];
+            int len = std::min(64, row_size - 64 * chunk);
+            for (int row = 0; row < 64; ++row) {
+                rows[row] = (row < num_rows) ?
+                    pack_row(&block[std::size_t(row) * row_size + 64 * chunk], len) : 0;
+            }
+            transpose64(rows);
+        }
+
+        // a word is added for each input with a value in the block
+        int num_spots = std::min(count, std::size_t(row_size));
+        for (int spot = 0; spot < num_spots; ++spot) {
+            vector<unsigned long long>& input_words = words[row_inputs[spot]];
+            if (int(input_words.size()) <= word) {
+                input_words.resize(word + 1, 0);
+            }
+            input_words[word] |= matrix[spot];
+        }
+        if (count < block_size) {
+            break;
+        }
+    }
+
+    // a file without values counts as one pattern
+    if (num_values == 0) {
+        return 1;
+    }
+    return (num_values + row_size - 1) / row_size;
+}
+
+int PatternReader::read_binary(const vector<string>& input_names,
+        vector<vector<unsigned long long> >& words)
+{
+    const char* pos = file.begin();
+    const char* end = file.end();
+    if (std::size_t(end - pos) < sizeof(PatternHeader)) {
+        throw Error("Invalid pattern file");
+    }
+    PatternHeader header;
+    memcpy(&header, pos, sizeof(header));
+    if (header.byte_order != PATTERN_BYTE_ORDER) {
+        throw Error("Pattern file was written on a host with another byte order");
+    }
+    if (header.version != PATTERN_VERSION) {
+        throw Error("Unsupported pattern file version");
+    }
+    pos += sizeof(header);
+
+    InputMap inputs;
+    map_inputs(input_names, inputs);
+
+    // inputs read from each row of words
+    vector<const vector<int>*> file_inputs;
+    std::size_t num_read = 0;
+    for (uint32_t i = 0; i < header.num_inputs; ++i) {
+        uint32_t size;
+        if (std::size_t(end - pos) < sizeof(size)) {
+            throw Error("Invalid pattern file");
+        }
+        memcpy(&size, pos, sizeof(size));
+        pos += sizeof(size);
+        if (std::size_t(end - pos) < size) {
+            throw Error("Invalid pattern file");
+        }
+        string name(pos, size);
+        pos += size;
+
+        InputMap::iterator iter = inputs.find(name);
+        if (iter == inputs.end()) {
+            throw Error("Could not find test input: " + name + " in circuit" );
+        }
+        file_inputs.push_back(&(iter->second));
+        num_read += iter->second.size();
+    }
+    if (num_read != input_names.size()) {
+        throw Error("Test file is missing circuit inputs");
+    }
+
+    pos += (8 - (pos - file.begin()) % 8) % 8;
+    std::size_t num_words = header.words_per_input;
+    if ((pos > end) ||
+            (std::size_t(end - pos) != num_words * header.num_inputs * sizeof(unsigned long long)) ||
+            (num_words > (std::size_t(header.num_patterns) + 63) / 64)) {
+        throw Error("Invalid pattern file");
+    }
+    if (num_words == 0) {
+        return header.num_patterns;
+    }
+
+    for (uint32_t i = 0; i < header.num_inputs; ++i, pos += num_words * sizeof(unsigned long long)) {
+        const vector<int>& targets = *(file_inputs[i]);
+        for (int j = 0; j < int(targets.size()); ++j) {
+            vector<unsigned long long>& input_words = words[targets[j]];
+            if (input_words.empty()) {
+                input_words.resize(num_words);
+                memcpy(&input_words[0], pos, num_words * sizeof(unsigned long long));
+                continue;
+            }
+            if (input_words.size() < num_words) {
+                input_words.resize(num_words, 0);
+            }
+            const unsigned long long* file_words = (const unsigned long long*)(pos);
+            for (std::size_t k = 0; k < num_words; ++k) {
+                input_words[k] |= file_words[k];
+            }
+        }
+    }
+    return header.num_patterns;
+}
+
+void write_pattern_file(const string& filename, const vector<string>& input_names,
+        const vector<vector<unsigned long long> >& words, int num_patterns)
+{
+    PatternHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PATTERN_MAGIC, sizeof(header.magic));
+    header.version = PATTERN_VERSION;
+    header.byte_order = PATTERN_BYTE_ORDER;
+    header.num_inputs = input_names.size();
+    header.num_patterns = num_patterns;
+    // a file without values still counts as one pattern, so the words
+    // are sized by what was read rather than by the pattern count
+    for (int i = 0; i < int(words.size()); ++i) {
+        header.words_per_input = std::max(header.words_per_input, uint32_t(words[i].size()));
+    }
+
+    string out((const char*)(&header), sizeof(header));
+    for (int i = 0; i < int(input_names.size()); ++i) {
+        uint32_t size = input_names[i].size();
+        out.append((const char*)(&size), sizeof(size));
+        out += input_names[i];
+    }
+    out.append((8 - out.size() % 8) % 8, '\0');
+
+    vector<unsigned long long> input_words;
+    for (int i = 0; i < int(words.size()); ++i) {
+        input_words = words[i];
+        input_words.resize(header.words_per_input, 0);
+        if (!input_words.empty()) {
+            out.append((const char*)(&input_words[0]),
+                    input_words.size() * sizeof(unsigned long long));
+        }
+    }
+
+    std::ofstream fout(filename.c_str(), std::ios::binary);
+    fout.write(out.data(), out.size());
+    if (!fout) {
+        throw Error("Cannot write pattern file");
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef PATTERNFILE_H
+#define PATTERNFILE_H
+
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+/*!
+ * Reads test patterns from a text file (a line of input names, then
+ * rows of 0s and 1s) or from the packed binary format written by
+ * write_pattern_file:
+ *
+ *   header (magic, version, byte order, number of inputs, number of
+ *   patterns, words per input), the input names (each a 32-bit length
+ *   and the characters, padded to 8 bytes), then the pattern words of
+ *   each input in name order (bit i of word j is pattern 64 * j + i)
+ *
+ * Binary files are recognized by their magic and copied word for word.
+*/
+class PatternReader {
+  public:
+    /*!
+     * Throws an Error if the file cannot be opened.
+    */
+    PatternReader(const std::string& filename);
+
+    /*!
+     * Read the patterns into words (one vector of words per input
+     * name; read bits are ORed into the words) and return the number
+     * of patterns.  Text files follow the rules of the original stream
+     * reader: header names are matched to every input of that name until
+     * all inputs are listed, whitespace between values is ignored, and
+     * rows continue where the previous one ended.  Throws an Error for
+     * unknown or missing inputs or a bad value.
+    */
+    int read(const std::vector<std::string>& input_names,
+            std::vector<std::vector<unsigned long long> >& words);
+
+  private:
+    int read_text(const std::vector<std::string>& input_names,
+            std::vector<std::vector<unsigned long long> >& words);
+    int read_binary(const std::vector<std::string>& input_names,
+            std::vector<std::vector<unsigned long long> >& words);
+
+    MappedFile file;
+};
+
+/*!
+ * Write patterns in the packed binary format.  Throws an Error if the
+ * file cannot be written.
+*/
+void write_pattern_file(const std::string& filename, const std::vector<std::string>& input_names,
+        const std::vector<std::vector<unsigned long long> >& words, int num_patterns);
+
+#endif
@@ -1,12 +1,20 @@
 #ifndef PORT_H
 #define PORT_H
 
+#include <string>
+#include "Netlist.h"
+
 class Wire;
 class Inst;
 
-class Port : public CircuitElement {
+/*!
+ * Pin of an instance.  Ports are created by a Netlist, which holds
+ * their names.
+*/
+class Port {
   public:
-    Port(std::string name_) : CircuitElement(name_) {}
+    Port(unsigned int name_id_, Netlist* netlist_, unsigned int id_) :
+        wire(0), inst(0), netlist(netlist_), name_id(name_id_), id(id_) {}
     
     void set_wire(Wire* wire_)
     {
@@ -27,15 +35,28 @@ class Port : public CircuitElement {
     {
         return inst;
     }
-    
-    CircuitElementType get_type() const
+
+    const std::string& get_name() const
+    {
+        return netlist->names.get(name_id);
+    }
+
+    unsigned int get_name_id() const
+    {
+        return name_id;
+    }
+
+    unsigned int get_id() const
     {
-        return PORT;   
+        return id;
     }
   
   private:
     Wire* wire;
     Inst* inst;
+    Netlist* netlist;
+    unsigned int name_id;
+    unsigned int id;
 };
 
 
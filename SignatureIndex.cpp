@@ -0,0 +1,166 @@
+#include "SignatureIndex.h"
+#include "Wire.h"
+
+#include <cassert>
+#include <algorithm>
+
+using std::vector;
+
+SignatureIndex::SignatureIndex(const vector<Wire*>& wires) :
+    num_words(0), num_indexed(0)
+{
+    for (std::size_t i = 0; i < wires.size(); ++i) {
+        if (wires[i]) {
+            num_words = wires[i]->num_sig_spots();
+            break;
+        }
+    }
+
+    num_bitmap_words = (wires.size() + 63) / 64;
+    sigs.assign(wires.size() * num_words + 1, 0);
+    pops.assign(wires.size(), 0);
+    leads.assign(wires.size(), 0);
+    bitmaps.assign(std::size_t(LEAD_BITS + 1) * num_bitmap_words + 1, 0);
+    bit_counts.assign(LEAD_BITS, 0);
+    unsigned long long* indexed = &bitmaps[0] + std::size_t(LEAD_BITS) * num_bitmap_words;
+    for (std::size_t i = 0; i < wires.size(); ++i) {
+        Wire* wire = wires[i];
+        if (!wire) {
+            continue;
+        }
+        assert(wire->num_sig_spots() == num_words);
+        unsigned long long* sig = &sigs[0] + i * num_words;
+        unsigned int pop = 0;
+        for (int k = 0; k < num_words; ++k) {
+            sig[k] = wire->get_signature(k);
+            pop += __builtin_popcountll(sig[k]);
+        }
+        pops[i] = pop;
+        leads[i] = num_words ? sig[0] : 0;
+
+        unsigned long long entry_bit = 1ULL << (i & 63);
+        indexed[i >> 6] |= entry_bit;
+        ++num_indexed;
+        for (int b = 0; b < LEAD_BITS; ++b) {
+            if ((leads[i] >> b) & 1) {
+                bitmaps[std::size_t(b) * num_bitmap_words + (i >> 6)] |= entry_bit;
+                ++bit_counts[b];
+            }
+        }
+    }
+}
+
+unsigned long long SignatureIndex::word_candidates(const Scan& scan, int word) const
+{
+    unsigned long long indexed = bitmap(LEAD_BITS)[word];
+    unsigned long long supersets = indexed;
+    for (int k = 0; k < scan.num_superset_bits; ++k) {
+        supersets &= bitmap(scan.superset_bits[k])[word];
+    }
+    unsigned long long subsets = indexed;
+    for (int k = 0; k < scan.num_subset_bits; ++k) {
+        subsets &= ~bitmap(scan.subset_bits[k])[word];
+    }
+    return supersets | subsets;
+}
+
+SignatureIndex::Scan SignatureIndex::start_scan(unsigned int query, unsigned int pos) const
+{
+    assert((bitmap(LEAD_BITS)[query >> 6] >> (query & 63)) & 1);
+    unsigned long long lead = leads[query];
+    Scan scan;
+    scan.query = query;
+
+    // the rarest set bits (fewest supersets) and the most common clear
+    // bits (fewest subsets) of the query, by insertion into short lists
+    scan.num_superset_bits = 0;
+    scan.num_subset_bits = 0;
+    unsigned int superset_sizes[SCAN_BITS];
+    unsigned int subset_sizes[SCAN_BITS];
+    for (int b = 0; b < LEAD_BITS; ++b) {
+        bool set = (lead >> b) & 1;
+        unsigned int size = set ? bit_counts[b] : num_indexed - bit_counts[b];
+        int* bits = set ? scan.superset_bits : scan.subset_bits;
+        unsigned int* sizes = set ? superset_sizes : subset_sizes;
+        int& num_bits = set ? scan.num_superset_bits : scan.num_subset_bits;
+        int k = num_bits;
+        if (k == SCAN_BITS) {
+            if (size >= sizes[k - 1]) {
+                continue;
+            }
+            --k;
+        } else {
+            ++num_bits;
+        }
+        for (; (k > 0) && (sizes[k - 1] > size); --k) {
+            bits[k] = bits[k - 1];
+            sizes[k] = sizes[k - 1];
+        }
+        bits[k] = b;
+        sizes[k] = size;
+    }
+
+    // only the entries below pos in its word
+    scan.word = int(pos >> 6);
+    scan.candidates = 0;
+    if (pos & 63) {
+        scan.candidates = word_candidates(scan, scan.word) & ((1ULL << (pos & 63)) - 1);
+    }
+    return scan;
+}
+
+bool SignatureIndex::next_cover(Scan& scan, unsigned int& entry, unsigned int& covers) const
+{
+    unsigned int pop = pops[scan.query];
+    unsigned long long lead = leads[scan.query];
+    while (true) {
+        while (scan.candidates == 0) {
+            if (scan.word == 0) {
+                return false;
+            }
+            --scan.word;
+            scan.candidates = word_candidates(scan, scan.word);
+        }
+        int k = 63 - __builtin_clzll(scan.candidates);
+        scan.candidates &= ~(1ULL << k);
+        entry = (scan.word << 6) + k;
+
+        // the popcount and whole leading word rule out the rest
+        bool superset = (pops[entry] >= pop) && ((leads[entry] & lead) == lead);
+        bool subset = (pops[entry] <= pop) && ((leads[entry] & ~lead) == 0);
+        if (!superset && !subset) {
+            continue;
+        }
+        covers = entry_covers(scan.query, entry, ALL_COVERS);
+        if (covers) {
+            return true;
+        }
+    }
+}
+
+unsigned int SignatureIndex::entry_covers(unsigned int entry1, unsigned int entry2,
+        unsigned int covers) const
+{
+    const unsigned long long* sig1 = signature(entry1);
+    const unsigned long long* sig2 = signature(entry2);
+
+    // AND: the first signature is a subset of the second; OR: a superset
+    bool subset = covers & (cover_bit(EQUAL) | cover_bit(AND));
+    bool superset = covers & (cover_bit(EQUAL) | cover_bit(OR));
+    for (int k = 0; (k < num_words) && (subset || superset); ++k) {
+        subset = subset && !(sig1[k] & ~sig2[k]);
+        superset = superset && !(sig2[k] & ~sig1[k]);
+    }
+
+    unsigned int found = 0;
+    if (subset && superset) {
+        found |= cover_bit(EQUAL);
+    }
+    if (subset) {
+        found |= cover_bit(AND);
+    }
+    if (superset) {
+        found |= cover_bit(OR);
+    }
+    return found & covers;
+}
@@ -0,0 +1,96 @@
+#ifndef SIGNATUREINDEX_H
+#define SIGNATUREINDEX_H
+
+#include <vector>
+
+class Wire;
+
+/*!
+ * Finds the wires whose signature covers, or is covered by, the
+ * signature of another wire (the candidate pairs of
+ * EncryptedCircuit::find_cover; equal signatures are both).  For each
+ * bit of the leading signature word the index keeps a bitmap of the
+ * entries that have it set.  A superset of the query is in the bitmap
+ * of every bit the query has and a subset outside the bitmap of every
+ * bit it lacks, so a scan intersects the bitmaps of the query's
+ * SCAN_BITS rarest set and clear bits, 64 entries at a time, from the
+ * largest entry down.  The signatures are copied in entry order when
+ * the index is built.
+*/
+class SignatureIndex {
+  public:
+    /*!
+     * Index the signatures of wires; entry i is wires[i].  Null wires
+     * are not indexed.
+    */
+    SignatureIndex(const std::vector<Wire*>& wires);
+
+    //! lead bits intersected by a scan for each kind of cover
+    static const int SCAN_BITS = 8;
+
+    //! state of a scan for covers (see start_scan)
+    struct Scan {
+        unsigned int query;
+        //! bits of the bitmaps that hold supersets and subsets
+        int num_superset_bits;
+        int superset_bits[SCAN_BITS];
+        int num_subset_bits;
+        int subset_bits[SCAN_BITS];
+        //! unread candidates of the current 64-entry word
+        int word;
+        unsigned long long candidates;
+    };
+
+    /*!
+     * Start a scan of the entries below pos for covers of entry query
+     * (which must be indexed), from the largest entry down.
+    */
+    Scan start_scan(unsigned int query, unsigned int pos) const;
+
+    /*!
+     * Next entry of the scan with a cover: covers (see cover_bit) holds
+     * the covers that hold between the signature of the query and the
+     * signature of the entry as for Wire::sig_equiv.  False when done.
+    */
+    bool next_cover(Scan& scan, unsigned int& entry, unsigned int& covers) const;
+
+    //! the covers of the set that hold between two entries
+    unsigned int entry_covers(unsigned int entry1, unsigned int entry2,
+            unsigned int covers) const;
+
+  private:
+    static const int LEAD_BITS = 64;
+
+    //! candidates of the scan among entries 64 * word to 64 * word + 63
+    unsigned long long word_candidates(const Scan& scan, int word) const;
+
+    //! bitmap of the entries with the lead bit set (bit LEAD_BITS: indexed)
+    const unsigned long long* bitmap(int bit) const
+    {
+        return &bitmaps[0] + std::size_t(bit) * num_bitmap_words;
+    }
+
+    const unsigned long long* signature(unsigned int entry) const
+    {
+        return &sigs[0] + std::size_t(entry) * num_words;
+    }
+
+    int num_words;
+
+    //! signature words of each entry (num_words per entry)
+    std::vector<unsigned long long> sigs;
+
+    //! popcount and first word of each signature (0 when not indexed)
+    std::vector<unsigned int> pops;
+    std::vector<unsigned long long> leads;
+
+    //! bitmaps of the lead bits and of the indexed entries
+    int num_bitmap_words;
+    std::vector<unsigned long long> bitmaps;
+
+    //! number of indexed entries with each lead bit set
+    std::vector<unsigned int> bit_counts;
+    unsigned int num_indexed;
+};
+
+#endif
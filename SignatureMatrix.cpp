@@ -0,0 +1,75 @@
+#include "SignatureMatrix.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+const unsigned int SIGNATURE_ALIGN = 64;
+const int SIGNATURE_ROW_WORDS = SIGNATURE_ALIGN / sizeof(unsigned long long);
+
+// row length rounded up to a whole number of aligned blocks
+static int row_stride(int words)
+{
+    return ((words + SIGNATURE_ROW_WORDS - 1) / SIGNATURE_ROW_WORDS) * SIGNATURE_ROW_WORDS;
+}
+
+SignatureMatrix::~SignatureMatrix()
+{
+    free(data);
+}
+
+void SignatureMatrix::reset(int num_rows_, int word_capacity)
+{
+    free(data);
+    data = 0;
+    num_rows = 0;
+    row_capacity = 0;
+    stride = 0;
+    num_words = 0;
+    reallocate(num_rows_, row_stride(word_capacity));
+}
+
+int SignatureMatrix::add_row()
+{
+    if (num_rows == row_capacity) {
+        reallocate(std::max(2 * row_capacity, 16), stride);
+    }
+    if (num_words > 0) {
+        memset(row(num_rows), 0, num_words * sizeof(unsigned long long));
+    }
+    return num_rows++;
+}
+
+void SignatureMatrix::resize_words(int num_words_)
+{
+    if (num_words_ > stride) {
+        reallocate(row_capacity, row_stride(std::max(num_words_, 2 * stride)));
+    }
+    for (int i = 0; (i < num_rows) && (num_words_ > num_words); ++i) {
+        memset(row(i) + num_words, 0, (num_words_ - num_words) * sizeof(unsigned long long));
+    }
+    num_words = num_words_;
+}
+
+void SignatureMatrix::reallocate(int row_capacity_, int stride_)
+{
+    unsigned long long* new_data = 0;
+    unsigned long long size = (unsigned long long)(row_capacity_) * stride_;
+    if (size > 0) {
+        void* mem = 0;
+        if (posix_memalign(&mem, SIGNATURE_ALIGN, size * sizeof(unsigned long long))) {
+            throw std::bad_alloc();
+        }
+        new_data = (unsigned long long*)(mem);
+    }
+
+    for (int i = 0; (i < num_rows) && (num_words > 0); ++i) {
+        memcpy(new_data + (unsigned long long)(i) * stride_, row(i),
+                num_words * sizeof(unsigned long long));
+    }
+    free(data);
+    data = new_data;
+    row_capacity = row_capacity_;
+    stride = stride_;
+}
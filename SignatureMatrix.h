@@ -0,0 +1,67 @@
+#ifndef SIGNATUREMATRIX_H
+#define SIGNATUREMATRIX_H
+
+/*!
+ * Signature words of a set of wires in one contiguous array.  Each
+ * wire owns a row of get_num_words() words; rows are padded to a
+ * multiple of 64 bytes and aligned so that a row can be read as
+ * 512-bit vectors.  Room for words is reserved up front, so
+ * simulations write into place without reallocating.
+*/
+class SignatureMatrix {
+  public:
+    SignatureMatrix() : data(0), num_rows(0), row_capacity(0), stride(0),
+        num_words(0) {}
+    ~SignatureMatrix();
+
+    /*!
+     * Drop all rows and words and reserve room for num_rows_ rows of
+     * word_capacity words.
+    */
+    void reset(int num_rows_, int word_capacity);
+
+    //! add a row (zero for the saved words) and return its id
+    int add_row();
+
+    /*!
+     * Make room for num_words_ words in every row; saved words are kept
+     * and new words are zero.
+    */
+    void resize_words(int num_words_);
+
+    int get_num_rows() const
+    {
+        return num_rows;
+    }
+
+    int get_num_words() const
+    {
+        return num_words;
+    }
+
+    unsigned long long* row(int id)
+    {
+        return data + (unsigned long long)(id) * stride;
+    }
+
+    const unsigned long long* row(int id) const
+    {
+        return data + (unsigned long long)(id) * stride;
+    }
+
+  private:
+    //! not copyable (wires refer to the matrix of their circuit)
+    SignatureMatrix(const SignatureMatrix&);
+    SignatureMatrix& operator=(const SignatureMatrix&);
+
+    //! move the rows to an array of row_capacity_ rows of stride_ words
+    void reallocate(int row_capacity_, int stride_);
+
+    unsigned long long* data;
+    int num_rows;
+    int row_capacity;
+    int stride;
+    int num_words;
+};
+
+#endif
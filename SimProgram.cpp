@@ -0,0 +1,407 @@
+#include "SimProgram.h"
+#include "Inst.h"
+#include "Port.h"
+#include "Wire.h"
+#include "TechLibrary.h"
+
+#include <boost/functional/hash.hpp>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIM_X86_DISPATCH
+typedef unsigned long long SimWord256 __attribute__((vector_size(32)));
+typedef unsigned long long SimWord512 __attribute__((vector_size(64)));
+#endif
+
+const unsigned int SIMVALUES_ALIGN = 64;
+
+SimValues::SimValues(const SimValues& rhs) : values(0), num_values(0)
+{
+    *this = rhs;
+}
+
+SimValues& SimValues::operator=(const SimValues& rhs)
+{
+    if (this != &rhs) {
+        assign(rhs.num_values);
+        if (num_values > 0) {
+            memcpy(values, rhs.values, num_values * sizeof(unsigned long long));
+        }
+    }
+    return *this;
+}
+
+SimValues::~SimValues()
+{
+    free(values);
+}
+
+void SimValues::assign(unsigned int size)
+{
+    if (size != num_values) {
+        free(values);
+        values = 0;
+        num_values = size;
+        if (size > 0) {
+            void* mem = 0;
+            if (posix_memalign(&mem, SIMVALUES_ALIGN, size * sizeof(unsigned long long))) {
+                throw std::bad_alloc();
+            }
+            values = (unsigned long long*)(mem);
+        }
+    }
+    if (num_values > 0) {
+        memset(values, 0, num_values * sizeof(unsigned long long));
+    }
+}
+
+int SimProgram::max_word_width = 0;
+
+void SimProgram::set_word_width(int bits)
+{
+    max_word_width = bits;
+}
+
+// pick the widest word allowed by the CPU and max_word_width
+static int detect_lanes(int max_bits)
+{
+#ifdef SIM_X86_DISPATCH
+    if ((max_bits == 0 || max_bits >= 512) && __builtin_cpu_supports("avx512f")) {
+        return 8;
+    }
+    if ((max_bits == 0 || max_bits >= 256) && __builtin_cpu_supports("avx2")) {
+        return 4;
+    }
+#endif
+    return 1;
+}
+
+void SimProgram::clear()
+{
+    ops.clear();
+    op_levels.clear();
+    max_level = 0;
+    fanins.clear();
+    fanout_offsets.clear();
+    fanout_ops.clear();
+    slot_wires.clear();
+    inst_ends.clear();
+    lanes = detect_lanes(max_word_width);
+    native_run = 0;
+
+    // slot 0 is reserved for unconnected inputs
+    slot_wires.push_back(0);
+}
+
+unsigned int SimProgram::add_wire(Wire* wire)
+{
+    if (!wire) {
+        return 0;
+    }
+    unsigned int slot = wire->get_slot();
+    if (slot < slot_wires.size() && slot_wires[slot] == wire) {
+        return slot;
+    }
+    slot = slot_wires.size();
+    wire->set_slot(slot);
+    slot_wires.push_back(wire);
+    return slot;
+}
+
+void SimProgram::add_inst(Inst* inst)
+{
+    unsigned int num_inputs = inst->num_inputs();
+    unsigned int fanin_begin = fanins.size();
+    for (unsigned int i = 0; i < num_inputs; ++i) {
+        fanins.push_back(add_wire(inst->get_input(i)->get_wire()));
+    }
+
+    for (unsigned int i = 0; i < inst->num_outputs(); ++i) {
+        Wire* owire = inst->get_output(i)->get_wire();
+        if (!owire) {
+            continue;
+        }
+
+        SimOp op;
+        op.out = add_wire(owire);
+        op.fanin_begin = fanin_begin;
+        op.num_inputs = num_inputs;
+        op.in0 = (num_inputs > 0) ? fanins[fanin_begin] : 0;
+        op.in1 = (num_inputs > 1) ? fanins[fanin_begin + 1] : 0;
+        op.in2 = (num_inputs > 2) ? fanins[fanin_begin + 2] : 0;
+        op.cell = inst->get_libcell(i);
+        op.code = SIM_CELL;
+
+        // cells too wide for a kernel are evaluated from the blif cover
+        if (!op.cell->has_kernel()) {
+            op.code = SIM_COVER;
+        } else if (num_inputs == 1) {
+            switch (op.cell->get_table_value()) {
+                case 2: op.code = SIM_BUF; break;
+                case 1: op.code = SIM_NOT; break;
+            }
+        } else if (num_inputs == 2) {
+            switch (op.cell->get_table_value()) {
+                case 6: op.code = SIM_XOR; break;
+                case 9: op.code = SIM_XNOR; break;
+                case 7: op.code = SIM_NAND; break;
+                case 13: op.code = SIM_NANDL; break;
+                case 11: op.code = SIM_NANDR; break;
+                case 1: op.code = SIM_NOR; break;
+                case 4: op.code = SIM_NORL; break;
+                case 2: op.code = SIM_NORR; break;
+                case 8: op.code = SIM_AND; break;
+                case 14: op.code = SIM_OR; break;
+            }
+        } else if (num_inputs == 3) {
+            if (op.cell->get_table_value() == 216) {
+                op.code = SIM_MUX;
+            }
+        }
+        ops.push_back(op);
+        op_levels.push_back(inst->get_level());
+        if (inst->get_level() > max_level) {
+            max_level = inst->get_level();
+        }
+    }
+    inst_ends[inst] = ops.size();
+}
+
+void SimProgram::build_fanouts()
+{
+    // count readers of each slot (an operation is listed once per slot)
+    fanout_offsets.assign(slot_wires.size() + 1, 0);
+    for (unsigned int i = 0; i < ops.size(); ++i) {
+        const unsigned int* in = op_fanins(ops[i]);
+        for (unsigned int j = 0; j < ops[i].num_inputs; ++j) {
+            bool repeat = false;
+            for (unsigned int k = 0; k < j; ++k) {
+                repeat = repeat || (in[k] == in[j]);
+            }
+            if (!repeat && in[j] != 0) {
+                ++fanout_offsets[in[j] + 1];
+            }
+        }
+    }
+    for (unsigned int i = 1; i < fanout_offsets.size(); ++i) {
+        fanout_offsets[i] += fanout_offsets[i - 1];
+    }
+
+    fanout_ops.assign(fanout_offsets.back() + 1, 0);
+    std::vector<unsigned int> spot(fanout_offsets.begin(), fanout_offsets.end() - 1);
+    for (unsigned int i = 0; i < ops.size(); ++i) {
+        const unsigned int* in = op_fanins(ops[i]);
+        for (unsigned int j = 0; j < ops[i].num_inputs; ++j) {
+            bool repeat = false;
+            for (unsigned int k = 0; k < j; ++k) {
+                repeat = repeat || (in[k] == in[j]);
+            }
+            if (!repeat && in[j] != 0) {
+                fanout_ops[spot[in[j]]++] = i;
+            }
+        }
+    }
+}
+
+void SimProgram::build_native()
+{
+    native_run = NativeSim::load(*this);
+}
+
+std::size_t SimProgram::netlist_hash() const
+{
+    std::size_t hash = 0;
+    for (unsigned int i = 1; i < slot_wires.size(); ++i) {
+        boost::hash_combine(hash, slot_wires[i]->get_name());
+    }
+    for (unsigned int i = 0; i < ops.size(); ++i) {
+        const SimOp& op = ops[i];
+        const unsigned int* in = op_fanins(op);
+        boost::hash_combine(hash, op.out);
+        for (unsigned int j = 0; j < op.num_inputs; ++j) {
+            boost::hash_combine(hash, in[j]);
+        }
+        boost::hash_combine(hash, op.cell->get_blif());
+    }
+    return hash;
+}
+
+unsigned int SimProgram::inst_end(Inst* inst) const
+{
+    std::tr1::unordered_map<Inst*, unsigned int>::const_iterator iter =
+        inst_ends.find(inst);
+    if (iter == inst_ends.end()) {
+        return 0;
+    }
+    return iter->second;
+}
+
+void SimProgram::run(unsigned long long* values, int num_sims,
+        unsigned int begin, unsigned int end) const
+{
+    int lane_sims[MAX_LANES];
+    for (int l = 0; l < lanes; ++l) {
+        int sims = num_sims - l * 64;
+        lane_sims[l] = (sims >= 64) ? 64 : ((sims > 0) ? sims : 0);
+    }
+    run(values, lane_sims, begin, end);
+}
+
+void SimProgram::run(unsigned long long* values, const int* lane_sims,
+        unsigned int begin, unsigned int end) const
+{
+    if (begin >= end) {
+        return;
+    }
+
+    // patterns beyond lane_sims are masked off lane by lane
+    unsigned long long masks[MAX_LANES];
+    for (int l = 0; l < lanes; ++l) {
+        if (lane_sims[l] >= 64) {
+            masks[l] = ~((unsigned long long)(0));
+        } else {
+            masks[l] = ((unsigned long long)(1) << lane_sims[l]) - 1;
+        }
+    }
+
+    if (native_run && (begin == 0) && (end == ops.size())) {
+        native_run(values, masks);
+        return;
+    }
+
+#ifdef SIM_X86_DISPATCH
+    if (lanes == 8) {
+        run_avx512(values, masks, begin, end);
+        return;
+    } else if (lanes == 4) {
+        run_avx2(values, masks, begin, end);
+        return;
+    }
+#endif
+    assert(lanes == 1);
+    run_words<unsigned long long>(values, masks, begin, end);
+}
+
+// runs the bitwise kernel of the cell over whole words (the result is
+// written through out: vector words are not returned by value from
+// code compiled without their target)
+template <typename Word>
+inline __attribute__((always_inline))
+void SimProgram::eval_kernel(const SimOp& op, const Word* words, Word* out) const
+{
+    Word regs[MAX_KERNEL_REGS];
+    regs[0] = words[0] ^ words[0];
+    regs[1] = ~regs[0];
+    const unsigned int* in = &fanins[0] + op.fanin_begin;
+    for (unsigned int i = 0; i < op.num_inputs; ++i) {
+        regs[2 + i] = words[in[i]];
+    }
+
+    const std::vector<CellOp>& kernel = op.cell->get_kernel();
+    Word* result = regs + 2 + op.num_inputs;
+    for (unsigned int i = 0; i < kernel.size(); ++i, ++result) {
+        const CellOp& kop = kernel[i];
+        switch (kop.code) {
+            case CellOp::AND: *result = regs[kop.a] & regs[kop.b]; break;
+            case CellOp::OR: *result = regs[kop.a] | regs[kop.b]; break;
+            case CellOp::XOR: *result = regs[kop.a] ^ regs[kop.b]; break;
+            case CellOp::ANDN: *result = regs[kop.a] & ~regs[kop.b]; break;
+            case CellOp::ORN: *result = regs[kop.a] | ~regs[kop.b]; break;
+            default:
+                *result = (regs[kop.c] & regs[kop.a]) | (~regs[kop.c] & regs[kop.b]);
+                break;
+        }
+    }
+    *out = regs[op.cell->get_kernel_out()];
+}
+
+// ORs the matching cubes of the cover (the first matching cube decides
+// the output, and the cover default applies where no cube matches)
+template <typename Word>
+inline __attribute__((always_inline))
+void SimProgram::eval_cover(const SimOp& op, const Word* words, Word* out) const
+{
+    const lib_cell* cell = op.cell;
+    const unsigned int* in = &fanins[0] + op.fanin_begin;
+    Word result = words[0] ^ words[0];
+    Word remaining = ~result;
+    for (int i = 0; i < cell->num_cubes(); ++i) {
+        Word match = remaining;
+        for (const unsigned int* lit = cell->cube_begin(i); lit != cell->cube_end(i); ++lit) {
+            if (*lit & 1) {
+                match &= words[in[*lit >> 1]];
+            } else {
+                match &= ~words[in[*lit >> 1]];
+            }
+        }
+        if (cell->get_cube_output(i)) {
+            result |= match;
+        }
+        remaining &= ~match;
+    }
+    if (cell->get_cover_default()) {
+        result |= remaining;
+    }
+    *out = result;
+}
+
+template <typename Word>
+inline __attribute__((always_inline))
+void SimProgram::run_words(unsigned long long* values, const unsigned long long* masks,
+        unsigned int begin, unsigned int end) const
+{
+    Word* words = (Word*)(values);
+    Word mask;
+    memcpy(&mask, masks, sizeof(Word));
+
+    const SimOp* op = &ops[0] + begin;
+    const SimOp* op_end = &ops[0] + end;
+    for (; op != op_end; ++op) {
+        Word sim1 = words[op->in0];
+        Word sim2 = words[op->in1];
+        Word result;
+
+        switch (op->code) {
+            case SIM_BUF: result = sim1; break;
+            case SIM_NOT: result = ~sim1; break;
+            case SIM_AND: result = sim1 & sim2; break;
+            case SIM_OR: result = sim1 | sim2; break;
+            case SIM_XOR: result = sim1 ^ sim2; break;
+            case SIM_XNOR: result = sim1 ^ (~sim2); break;
+            case SIM_NAND: result = ~(sim1 & sim2); break;
+            case SIM_NOR: result = ~(sim1 | sim2); break;
+            case SIM_NANDL: result = ~((~sim1) & sim2); break;
+            case SIM_NANDR: result = ~(sim1 & (~sim2)); break;
+            case SIM_NORL: result = sim1 & (~sim2); break;
+            case SIM_NORR: result = (~sim1) & sim2; break;
+            case SIM_MUX:
+                {
+                    Word sim3 = words[op->in2];
+                    result = ((~sim3) & sim1) | (sim3 & sim2);
+                    break;
+                }
+            case SIM_CELL: eval_kernel<Word>(*op, words, &result); break;
+            default: eval_cover<Word>(*op, words, &result); break;
+        }
+        words[op->out] = result & mask;
+    }
+}
+
+#ifdef SIM_X86_DISPATCH
+__attribute__((target("avx2")))
+void SimProgram::run_avx2(unsigned long long* values, const unsigned long long* masks,
+        unsigned int begin, unsigned int end) const
+{
+    run_words<SimWord256>(values, masks, begin, end);
+}
+
+__attribute__((target("avx512f")))
+void SimProgram::run_avx512(unsigned long long* values, const unsigned long long* masks,
+        unsigned int begin, unsigned int end) const
+{
+    run_words<SimWord512>(values, masks, begin, end);
+}
+#endif
@@ -0,0 +1,250 @@
+#ifndef SIMPROGRAM_H
+#define SIMPROGRAM_H
+
+#include <vector>
+#include <tr1/unordered_map>
+#include "NativeSim.h"
+
+class Wire;
+class Inst;
+class lib_cell;
+
+//! operation codes for the compiled simulator
+enum SimOpCode { SIM_BUF, SIM_NOT, SIM_AND, SIM_OR, SIM_XOR, SIM_XNOR,
+    SIM_NAND, SIM_NOR, SIM_NANDL, SIM_NANDR, SIM_NORL, SIM_NORR, SIM_MUX,
+    SIM_CELL, SIM_COVER };
+
+/*!
+ * Single output evaluation in the compiled simulator.  The first three
+ * fanins are stored inline; all fanins are also available in the
+ * program fanin array for cell kernel and cover evaluation.
+*/
+struct SimOp {
+    SimOpCode code;
+    unsigned int out;
+    unsigned int in0, in1, in2;
+    unsigned int fanin_begin;
+    unsigned int num_inputs;
+    lib_cell* cell;
+};
+
+/*!
+ * Value array for a SimProgram.  Slot i occupies lanes consecutive
+ * 64-bit words starting at i * lanes.  The array is aligned so that
+ * a slot can be loaded as a single 256 or 512-bit vector.
+*/
+class SimValues {
+  public:
+    SimValues() : values(0), num_values(0) {}
+    SimValues(const SimValues& rhs);
+    SimValues& operator=(const SimValues& rhs);
+    ~SimValues();
+
+    /*!
+     * Resize the array; all values are set to 0.
+    */
+    void assign(unsigned int size);
+
+    unsigned int size() const
+    {
+        return num_values;
+    }
+
+    unsigned long long* get()
+    {
+        return values;
+    }
+
+    const unsigned long long* get() const
+    {
+        return values;
+    }
+
+    unsigned long long& operator[](unsigned int i)
+    {
+        return values[i];
+    }
+
+  private:
+    unsigned long long* values;
+    unsigned int num_values;
+};
+
+/*!
+ * Flat, levelized view of a circuit used for simulation.  Every wire
+ * is given a dense slot in a value array and every instance output
+ * becomes an operation over slot ids, so a whole-circuit pass is a
+ * single loop over a contiguous array.  Slot 0 is always constant 0
+ * and is used for unconnected inputs.
+ *
+ * Each slot holds get_lanes() 64-bit words, so one pass simulates
+ * 64 * get_lanes() patterns.  The widest word supported by the CPU
+ * (AVX-512, AVX2, or plain 64-bit) is chosen when the program is built.
+*/
+class SimProgram {
+  public:
+    //! widest word is 512 bits
+    static const int MAX_LANES = 8;
+
+    SimProgram()
+    {
+        clear();
+    }
+
+    void clear();
+
+    /*!
+     * Limit the simulation word width (64, 256, or 512 bits).  A width
+     * of 0 uses the widest word supported by the CPU.  Only affects
+     * programs built after the call.
+    */
+    static void set_word_width(int bits);
+
+    /*!
+     * Returns the slot for the wire, allocating one if the wire
+     * has not been seen by this program.
+    */
+    unsigned int add_wire(Wire* wire);
+
+    /*!
+     * Compiles all outputs of an instance.  Instances must be added
+     * in levelized order.
+    */
+    void add_inst(Inst* inst);
+
+    unsigned int num_slots() const
+    {
+        return slot_wires.size();
+    }
+
+    unsigned int num_ops() const
+    {
+        return ops.size();
+    }
+
+    //! number of 64-bit lanes in each simulation word
+    int get_lanes() const
+    {
+        return lanes;
+    }
+
+    Wire* get_wire(unsigned int slot) const
+    {
+        return slot_wires[slot];
+    }
+
+    /*!
+     * Index one past the last operation for the instance (or 0 if
+     * the instance is not in the program).
+    */
+    unsigned int inst_end(Inst* inst) const;
+
+    const SimOp& get_op(unsigned int id) const
+    {
+        return ops[id];
+    }
+
+    //! level of the instance that the operation evaluates
+    int get_op_level(unsigned int id) const
+    {
+        return op_levels[id];
+    }
+
+    int get_max_level() const
+    {
+        return max_level;
+    }
+
+    //! fanin slots of an operation
+    const unsigned int* op_fanins(const SimOp& op) const
+    {
+        return &fanins[0] + op.fanin_begin;
+    }
+
+    /*!
+     * Build the slot to reading-operation map.  Must be called once
+     * all instances are added.
+    */
+    void build_fanouts();
+
+    /*!
+     * Compile the program to native code if NativeSim is enabled.  Full
+     * passes (all operations) then run the native code.  Must be called
+     * once all instances are added.
+    */
+    void build_native();
+
+    /*!
+     * Hash of the compiled netlist: the wire name of every slot and the
+     * fanin slots and cell cover of every operation.  Does not depend
+     * on the word width.
+    */
+    std::size_t netlist_hash() const;
+
+    //! operations that read the slot are [fanout_begin, fanout_end)
+    const unsigned int* fanout_begin(unsigned int slot) const
+    {
+        return &fanout_ops[0] + fanout_offsets[slot];
+    }
+    const unsigned int* fanout_end(unsigned int slot) const
+    {
+        return &fanout_ops[0] + fanout_offsets[slot + 1];
+    }
+
+    /*!
+     * Run operations [begin, end) over the value array.  Only the
+     * first num_sims patterns of each word are valid; gate outputs
+     * are zeroed above that.
+    */
+    void run(unsigned long long* values, int num_sims,
+            unsigned int begin, unsigned int end) const;
+
+    void run(unsigned long long* values, int num_sims) const
+    {
+        run(values, num_sims, 0, ops.size());
+    }
+
+    /*!
+     * Run operations [begin, end) where the number of valid patterns
+     * is given separately for each lane.
+    */
+    void run(unsigned long long* values, const int* lane_sims,
+            unsigned int begin, unsigned int end) const;
+
+  private:
+    template <typename Word>
+    void eval_kernel(const SimOp& op, const Word* words, Word* out) const;
+
+    template <typename Word>
+    void eval_cover(const SimOp& op, const Word* words, Word* out) const;
+
+    template <typename Word>
+    void run_words(unsigned long long* values, const unsigned long long* masks,
+            unsigned int begin, unsigned int end) const;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __attribute__((target("avx2")))
+    void run_avx2(unsigned long long* values, const unsigned long long* masks,
+            unsigned int begin, unsigned int end) const;
+    __attribute__((target("avx512f")))
+    void run_avx512(unsigned long long* values, const unsigned long long* masks,
+            unsigned int begin, unsigned int end) const;
+#endif
+
+    std::vector<SimOp> ops;
+    std::vector<int> op_levels;
+    int max_level;
+    std::vector<unsigned int> fanins;
+    std::vector<unsigned int> fanout_offsets;
+    std::vector<unsigned int> fanout_ops;
+    std::vector<Wire*> slot_wires;
+    std::tr1::unordered_map<Inst*, unsigned int> inst_ends;
+    int lanes;
+
+    //! native code for a full pass (0 if not built)
+    NativeSimFunc native_run;
+
+    static int max_word_width;
+};
+
+#endif
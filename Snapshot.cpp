@@ -0,0 +1,16 @@
+#include "Snapshot.h"
+
+#include <fstream>
+#include <cstring>
+
+using std::string;
+
+bool is_snapshot_file(const string& filename)
+{
+    std::ifstream fin(filename.c_str(), std::ios::binary);
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    if (!fin.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
@@ -0,0 +1,123 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <stdint.h>
+
+/*!
+ * Binary netlist of a levelized circuit (written by
+ * Circuit::write_snapshot, see --write-binary-netlist), read instead of
+ * a BLIF file to skip parsing and levelization.  The file is a header
+ * followed by arrays of 32-bit records that refer to each other by
+ * index, in this order:
+ *
+ *   strings (SnapshotString), cells, insts, wires, ports, symbols,
+ *   links, lib_insts, linsts, input_wires, output_wires, key_wires,
+ *   key_values, new_gates, string bytes
+ *
+ * Records use the byte order of the host that wrote them.  Loading is
+ * one pass over the records that creates every Wire, Inst and Port
+ * and links them as the BLIF reader would; the circuit does not point
+ * into the file, so each process holds its own copy of the netlist.
+ *
+ * The binary netlist of a locked circuit holds the locked netlist
+ * only, not the netlist before locking, so it cannot be locked again
+ * or used as the reference for cracking.
+*/
+
+//! first bytes of every binary netlist
+const char SNAPSHOT_MAGIC[8] = { 'C', 'L', 'S', 'N', 'A', 'P', '\r', '\n' };
+
+//! incremented whenever the layout changes
+const uint32_t SNAPSHOT_VERSION = 1;
+
+//! value of a missing index
+const uint32_t SNAPSHOT_NONE = 0xffffffff;
+
+//! detects snapshots written on a host with another byte order
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+//! Inst flags
+const uint32_t SNAPSHOT_INST_PORT = 1;
+const uint32_t SNAPSHOT_INST_LATCH = 2;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+
+    uint32_t num_strings;
+    uint32_t num_cells;
+    uint32_t num_insts;
+    uint32_t num_wires;
+    uint32_t num_ports;
+    uint32_t num_symbols;
+    uint32_t num_links;
+    uint32_t num_lib_insts;
+    uint32_t num_linsts;
+    uint32_t num_input_wires;
+    uint32_t num_output_wires;
+    uint32_t num_key_wires;
+    uint32_t num_new_gates;
+    uint32_t string_bytes;
+
+    //! Circuit counters
+    int32_t inst_count;
+    int32_t wire_count;
+    int32_t gate_count;
+    int32_t port_count;
+    int32_t max_level;
+};
+
+//! [offset, offset + size) of the string bytes
+struct SnapshotString {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct SnapshotCell {
+    uint32_t num_inputs;
+    uint32_t table;
+};
+
+//! links holds the input ports, output ports, then the cells
+struct SnapshotInst {
+    uint32_t name;
+    uint32_t flags;
+    int32_t level;
+    uint32_t num_inputs;
+    uint32_t num_outputs;
+    uint32_t num_cells;
+    uint32_t links;
+};
+
+//! links holds the output ports
+struct SnapshotWire {
+    uint32_t name;
+    uint32_t driver;
+    uint32_t num_outputs;
+    uint32_t links;
+    uint32_t sig_temp_low;
+    uint32_t sig_temp_high;
+};
+
+struct SnapshotPort {
+    uint32_t name;
+    uint32_t inst;
+    uint32_t wire;
+};
+
+//! sym_table entry (type is a CircuitElementType)
+struct SnapshotSymbol {
+    uint32_t name;
+    uint32_t type;
+    uint32_t id;
+};
+
+/*!
+ * True if the file starts with the snapshot magic (false if it cannot
+ * be read).
+*/
+bool is_snapshot_file(const std::string& filename);
+
+#endif
@@ -1,6 +1,9 @@
 #include "TechLibrary.h"
 
 using std::string;
+using std::vector;
+using std::pair;
+using std::make_pair;
 
 int lib_cell::simulate(string& inputstr)
 {
@@ -39,6 +42,140 @@ int lib_cell::simulate(string& inputstr)
     return 1 - output_val;
 }
 
+void lib_cell::compile_kernel()
+{
+    kernel.clear();
+    kernel_out = 0xff;
+    if (num_inputs > MAX_KERNEL_INPUTS) {
+        return;
+    }
+
+    unsigned long long table = 0;
+    for (int minterm = 0; minterm < (1 << num_inputs); ++minterm) {
+        if (ttable[minterm]) {
+            table |= ((unsigned long long)(1) << minterm);
+        }
+    }
+
+    // cofactors already computed, for each number of remaining inputs
+    vector<pair<unsigned long long, unsigned char> > memo[MAX_KERNEL_INPUTS + 1];
+    kernel_out = expand_kernel(table, 0, memo);
+}
+
+// inputs[0] is the most significant bit of the minterm, so the cofactors
+// on input var are the upper and lower halves of the table
+unsigned char lib_cell::expand_kernel(unsigned long long table, int var,
+        vector<pair<unsigned long long, unsigned char> >* memo)
+{
+    int remaining = num_inputs - var;
+    unsigned long long full = (remaining == 6) ? ~((unsigned long long)(0)) :
+        (((unsigned long long)(1) << (1 << remaining)) - 1);
+    if (table == 0) {
+        return 0;
+    }
+    if (table == full) {
+        return 1;
+    }
+    for (int i = 0; i < int(memo[remaining].size()); ++i) {
+        if (memo[remaining][i].first == table) {
+            return memo[remaining][i].second;
+        }
+    }
+
+    int half = 1 << (remaining - 1);
+    unsigned long long half_mask = (((unsigned long long)(1) << half) - 1);
+    unsigned long long table0 = table & half_mask;
+    unsigned long long table1 = (table >> half) & half_mask;
+    unsigned char sel = 2 + var;
+
+    CellOp op;
+    if (table0 == table1) {
+        return expand_kernel(table0, var + 1, memo);
+    } else if ((table0 == 0) && (table1 == half_mask)) {
+        return sel;
+    } else if ((table0 == half_mask) && (table1 == 0)) {
+        op.code = CellOp::XOR;
+        op.a = sel;
+        op.b = 1;
+    } else if ((table0 ^ table1) == half_mask) {
+        op.code = CellOp::XOR;
+        op.a = sel;
+        op.b = expand_kernel(table0, var + 1, memo);
+    } else if (table0 == 0) {
+        op.code = CellOp::AND;
+        op.a = sel;
+        op.b = expand_kernel(table1, var + 1, memo);
+    } else if (table1 == 0) {
+        op.code = CellOp::ANDN;
+        op.a = expand_kernel(table0, var + 1, memo);
+        op.b = sel;
+    } else if (table1 == half_mask) {
+        op.code = CellOp::OR;
+        op.a = sel;
+        op.b = expand_kernel(table0, var + 1, memo);
+    } else if (table0 == half_mask) {
+        op.code = CellOp::ORN;
+        op.a = expand_kernel(table1, var + 1, memo);
+        op.b = sel;
+    } else {
+        op.code = CellOp::MUX;
+        op.a = expand_kernel(table1, var + 1, memo);
+        op.b = expand_kernel(table0, var + 1, memo);
+        op.c = sel;
+    }
+
+    unsigned char reg = 2 + num_inputs + kernel.size();
+    kernel.push_back(op);
+    memo[remaining].push_back(make_pair(table, reg));
+    return reg;
+}
+
+void lib_cell::compile_cover()
+{
+    cube_literals.clear();
+    cube_offsets.assign(1, 0);
+    cube_outputs.clear();
+
+    // same scan as simulate(): the first num_inputs characters of a row
+    // are literals and the last 0/1 after them is the output (an output
+    // carries over to rows that do not give one)
+    int output_val = 0;
+    size_t row_begin = 0;
+    while (row_begin < blif.size()) {
+        size_t row_end = blif.find('\n', row_begin);
+        if (row_end == string::npos) {
+            row_end = blif.size();
+        }
+
+        bool valid = (row_end - row_begin) >= size_t(num_inputs);
+        vector<unsigned int> literals;
+        for (int i = 0; valid && (i < num_inputs); ++i) {
+            char lit = blif[row_begin + i];
+            if (lit == '0') {
+                literals.push_back(i << 1);
+            } else if (lit == '1') {
+                literals.push_back((i << 1) | 1);
+            } else if (lit != '-') {
+                // can never match an input value
+                valid = false;
+            }
+        }
+        for (size_t i = row_begin + num_inputs; i < row_end; ++i) {
+            if (blif[i] == '0' || blif[i] == '1') {
+                output_val = (blif[i] == '0') ? 0 : 1;
+            }
+        }
+
+        if (valid) {
+            cube_literals.insert(cube_literals.end(), literals.begin(), literals.end());
+            cube_offsets.push_back(cube_literals.size());
+            cube_outputs.push_back(output_val);
+        }
+        row_begin = row_end + 1;
+    }
+    cover_default = (output_val == 0);
+}
+
 lib_cell* TechLibrary::create_libcell(string blif, int num_inputs)
 {
     lib_cell lcell(num_inputs, blif);
@@ -61,6 +198,10 @@ lib_cell* TechLibrary::create_libcell(string blif, int num_inputs)
                 int result = lcell.simulate(minstr);
                 lcell.set_minterm(minterm, result);
             }
+            lcell.compile_kernel();
+        }
+        if (!lcell.has_kernel()) {
+            lcell.compile_cover();
         }
 
         nlcell= new lib_cell(lcell);
@@ -3,15 +3,35 @@
 
 #include <bitset>
 #include <string>
+#include <vector>
 #include <tr1/unordered_set>
 #include <boost/functional/hash.hpp>
 
-// currently, all cells with > 8 inputs does not use truth table and still
-// uses blif
+/*!
+ * Bitwise operation in a compiled cell kernel.  Operands are kernel
+ * registers: 0 is constant 0, 1 is constant 1 (all ones), 2 to
+ * 2 + num_inputs - 1 are the cell inputs, and operation i writes
+ * register 2 + num_inputs + i.
+*/
+struct CellOp {
+    //! AND, OR, XOR, ANDN (a & ~b), ORN (a | ~b), MUX (c ? a : b)
+    enum Code { AND, OR, XOR, ANDN, ORN, MUX };
+    unsigned char code;
+    unsigned char a, b, c;
+};
+
+//! largest cell compiled into a kernel
+const int MAX_KERNEL_INPUTS = 6;
+
+//! enough registers for any kernel of MAX_KERNEL_INPUTS inputs
+const int MAX_KERNEL_REGS = 2 + MAX_KERNEL_INPUTS + (1 << MAX_KERNEL_INPUTS);
+
+// currently, all cells with > 8 inputs does not use truth table; cells
+// with > 6 inputs are simulated from the cube cover of the blif
 class lib_cell {
   public:
     lib_cell(int num_inputs_, std::string blif_) : 
-        num_inputs(num_inputs_), blif(blif_) {}
+        num_inputs(num_inputs_), blif(blif_), kernel_out(0xff) {}
       
     /*!
      * Simulate output given input given by string of 0/1s
@@ -34,7 +54,71 @@ class lib_cell {
         return ttable.to_ulong();
     } 
 
-    std::string get_blif() const
+    int get_num_inputs() const
+    {
+        return num_inputs;
+    }
+
+    /*!
+     * Build the bitwise kernel from the truth table (by Shannon
+     * expansion on the inputs, sharing equal cofactors).  Only
+     * for cells with <= MAX_KERNEL_INPUTS inputs.
+    */
+    void compile_kernel();
+
+    bool has_kernel() const
+    {
+        return kernel_out != 0xff;
+    }
+
+    const std::vector<CellOp>& get_kernel() const
+    {
+        return kernel;
+    }
+
+    //! register holding the output after the kernel runs
+    unsigned char get_kernel_out() const
+    {
+        return kernel_out;
+    }
+
+    /*!
+     * Parse the blif rows into cubes for bit-parallel evaluation.  The
+     * output is the output of the first cube that matches, or
+     * get_cover_default() if no cube matches (as in simulate()).
+    */
+    void compile_cover();
+
+    int num_cubes() const
+    {
+        return cube_outputs.size();
+    }
+
+    /*!
+     * Literals of the cube are [cube_begin(i), cube_end(i)).  A literal
+     * is (input << 1) | 1 for a positive literal and input << 1 for a
+     * negative literal.
+    */
+    const unsigned int* cube_begin(int cube) const
+    {
+        return cube_literals.empty() ? 0 : &cube_literals[0] + cube_offsets[cube];
+    }
+    const unsigned int* cube_end(int cube) const
+    {
+        return cube_literals.empty() ? 0 : &cube_literals[0] + cube_offsets[cube + 1];
+    }
+
+    bool get_cube_output(int cube) const
+    {
+        return cube_outputs[cube];
+    }
+
+    bool get_cover_default() const
+    {
+        return cover_default;
+    }
+
+    const std::string& get_blif() const
     {
         return blif;
     }
@@ -43,6 +127,18 @@ class lib_cell {
     int num_inputs;  // Number of inputs
     std::bitset<256> ttable; // Truth table, for <= 8 inputs only
     std::string blif; // blif ttable representation
+
+    //! returns the register computing the table over inputs [var, num_inputs)
+    unsigned char expand_kernel(unsigned long long table, int var, 
+            std::vector<std::pair<unsigned long long, unsigned char> >* memo);
+
+    std::vector<CellOp> kernel;
+    unsigned char kernel_out;
+
+    std::vector<unsigned int> cube_literals;
+    std::vector<unsigned int> cube_offsets;
+    std::vector<bool> cube_outputs;
+    bool cover_default;
 };
 
 struct lib_cell_hash {
@@ -52,6 +148,14 @@ struct lib_cell_hash {
     }
 };
 
+struct lib_cell_equal {
+    bool operator()(const lib_cell* cell1, const lib_cell* cell2) const
+    {
+        return (cell1->get_num_inputs() == cell2->get_num_inputs()) &&
+            (cell1->get_blif() == cell2->get_blif());
+    }
+};
+
 // ?! allow blif to be build from ttable ?? (in old circuit)
 
 /*!
@@ -69,7 +173,7 @@ class TechLibrary {
 
   private:
     //! each cell has only one output
-    typedef std::tr1::unordered_set<lib_cell*, lib_cell_hash> Library_t;
+    typedef std::tr1::unordered_set<lib_cell*, lib_cell_hash, lib_cell_equal> Library_t;
     Library_t cells;
 };
 
@@ -0,0 +1,111 @@
+#include "ThreadPool.h"
+#include <boost/bind.hpp>
+
+int ThreadPool::default_threads = 1;
+
+ThreadPool::ThreadPool(int num_threads_) : num_threads(num_threads_),
+    num_tasks(0), next_task(0), tasks_finished(0), generation(0), shutdown(false)
+{
+    if (num_threads <= 0) {
+        num_threads = boost::thread::hardware_concurrency();
+    }
+    if (num_threads <= 0) {
+        num_threads = 1;
+    }
+
+    // the calling thread is the first worker
+    for (int i = 1; i < num_threads; ++i) {
+        workers.create_thread(boost::bind(&ThreadPool::worker_loop, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        shutdown = true;
+    }
+    work_ready.notify_all();
+    workers.join_all();
+}
+
+ThreadPool& ThreadPool::instance()
+{
+    static ThreadPool pool(default_threads);
+    return pool;
+}
+
+void ThreadPool::set_default_threads(int num_threads_)
+{
+    default_threads = num_threads_;
+}
+
+void ThreadPool::run(int num_tasks_, Task task_)
+{
+    if (num_threads == 1 || num_tasks_ <= 1) {
+        for (int i = 0; i < num_tasks_; ++i) {
+            task_(i);
+        }
+        return;
+    }
+
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        task = task_;
+        num_tasks = num_tasks_;
+        next_task = 0;
+        tasks_finished = 0;
+        ++generation;
+    }
+    work_ready.notify_all();
+
+    execute_tasks();
+
+    boost::mutex::scoped_lock lock(mutex);
+    while (tasks_finished < num_tasks) {
+        work_done.wait(lock);
+    }
+    task.clear();
+}
+
+void ThreadPool::worker_loop()
+{
+    unsigned int seen_generation = 0;
+    while (true) {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            while (!shutdown && (generation == seen_generation)) {
+                work_ready.wait(lock);
+            }
+            if (shutdown) {
+                return;
+            }
+            seen_generation = generation;
+        }
+        execute_tasks();
+    }
+}
+
+// grab tasks from the current loop until none remain
+void ThreadPool::execute_tasks()
+{
+    while (true) {
+        int id;
+        Task current;
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            if (next_task >= num_tasks) {
+                return;
+            }
+            id = next_task++;
+            current = task;
+        }
+
+        current(id);
+
+        boost::mutex::scoped_lock lock(mutex);
+        if (++tasks_finished == num_tasks) {
+            work_done.notify_all();
+        }
+    }
+}
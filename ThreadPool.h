@@ -0,0 +1,70 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+/*!
+ * Fixed set of worker threads that run parallel loops.  A loop is
+ * given as a function of the task id; run() returns once every task
+ * is finished.  The calling thread also executes tasks.  With one
+ * thread, tasks run in order on the calling thread.
+*/
+class ThreadPool {
+  public:
+    typedef boost::function<void (int)> Task;
+
+    ThreadPool(int num_threads_);
+    ~ThreadPool();
+
+    int get_num_threads() const
+    {
+        return num_threads;
+    }
+
+    /*!
+     * Run task(id) for every id in [0, num_tasks).  Must not be called
+     * from inside a task.
+    */
+    void run(int num_tasks, Task task);
+
+    /*!
+     * Process-wide pool used by the simulation and analysis routines.
+    */
+    static ThreadPool& instance();
+
+    /*!
+     * Set the size of the process-wide pool (must be called before
+     * instance() is first used to take effect).  A value of 0 uses
+     * all hardware threads.
+    */
+    static void set_default_threads(int num_threads_);
+
+  private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void worker_loop();
+    void execute_tasks();
+
+    int num_threads;
+    boost::thread_group workers;
+    boost::mutex mutex;
+    boost::condition_variable work_ready;
+    boost::condition_variable work_done;
+
+    //! current parallel loop
+    Task task;
+    int num_tasks;
+    int next_task;
+    int tasks_finished;
+    unsigned int generation;
+    bool shutdown;
+
+    static int default_threads;
+};
+
+#endif
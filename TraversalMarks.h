@@ -0,0 +1,85 @@
+#ifndef TRAVERSALMARKS_H
+#define TRAVERSALMARKS_H
+
+#include <vector>
+#include <algorithm>
+#include "CircuitElement.h"
+
+/*!
+ * Elements visited by one traversal, indexed by element type and id.
+ * A mark is the epoch of the traversal that set it, so starting a new
+ * traversal clears every mark in O(1).  The marks do not touch the
+ * elements: traversals with their own marks can run on the same
+ * circuit at once.
+*/
+class TraversalMarks {
+  public:
+    TraversalMarks() : epoch(0) {}
+
+    //! clear all marks and make room for the elements of netlist
+    void start(const Netlist& netlist)
+    {
+        if (++epoch == 0) {
+            // stamps of old traversals could match again
+            for (int i = 0; i < NUM_TYPES; ++i) {
+                std::fill(stamps[i].begin(), stamps[i].end(), 0);
+            }
+            epoch = 1;
+        }
+        reserve(INST, netlist.num_insts());
+        reserve(WIRE, netlist.num_wires());
+        reserve(PORT, netlist.num_ports());
+    }
+
+    bool is_marked(const CircuitElement* element) const
+    {
+        const std::vector<unsigned int>& type_stamps = stamps[element->get_type()];
+        unsigned int id = element->get_id();
+        return (id < type_stamps.size()) && (type_stamps[id] == epoch);
+    }
+
+    //! elements created after start() can be marked too
+    void mark(const CircuitElement* element)
+    {
+        std::vector<unsigned int>& type_stamps = stamps[element->get_type()];
+        unsigned int id = element->get_id();
+        if (id >= type_stamps.size()) {
+            type_stamps.resize(id + 1, 0);
+        }
+        type_stamps[id] = epoch;
+    }
+
+    void unmark(const CircuitElement* element)
+    {
+        std::vector<unsigned int>& type_stamps = stamps[element->get_type()];
+        unsigned int id = element->get_id();
+        if (id < type_stamps.size()) {
+            type_stamps[id] = 0;
+        }
+    }
+
+    //! mark the element; false if it was already marked
+    bool visit(const CircuitElement* element)
+    {
+        if (is_marked(element)) {
+            return false;
+        }
+        mark(element);
+        return true;
+    }
+
+  private:
+    static const int NUM_TYPES = PORT + 1;
+
+    void reserve(CircuitElementType type, unsigned int size)
+    {
+        if (stamps[type].size() < size) {
+            stamps[type].resize(size, 0);
+        }
+    }
+
+    std::vector<unsigned int> stamps[NUM_TYPES];
+    unsigned int epoch;
+};
+
+#endif
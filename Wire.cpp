@@ -5,7 +5,7 @@
 // add port. isw=0: input, 1: output
 void Wire::add_output_port(Port* port)
 {
-    outputs.push_back(port);
+    netlist->fanouts.push_back(outputs, port);
     port->set_wire(this);
 }
 
@@ -18,46 +18,66 @@ void Wire::set_driver(Port* in_port)
 // will add wire's outputs to this
 void Wire::reassign_outputs(Wire* wire)
 {
-    for (unsigned int i = 0; i < wire->outputs.size(); ++i) {
-        add_output_port(wire->outputs[0]);
+    for (unsigned int i = 0; i < wire->outputs.size; ++i) {
+        add_output_port(wire->get_output(0));
     }
-    wire->outputs.clear();
+    wire->outputs.size = 0;
 }
 
 int Wire::sig_diffs(Wire& wire1)
 {
-    assert(signatures.size() == wire1.signatures.size());
+    assert(num_sig_spots() == wire1.num_sig_spots());
+    int num_words = num_sig_spots();
+    if (num_words == 0) {
+        return 0;
+    }
+    const unsigned long long* sigs = sig_matrix->row(sig_row);
+    const unsigned long long* sigs1 = wire1.sig_matrix->row(wire1.sig_row);
     int diffs = 0;
-    for (int i = 0; i < int(signatures.size()); ++i) {
-        unsigned long long mask = 1;
-        for (int j = 0; j < int(SIGSTEP); ++j) {
-            unsigned long long val = signatures[i] & (mask << j);
-            unsigned long long val1 = wire1.signatures[i] & (mask << j);
-            if (val != val1) {
-                ++diffs;
-            }
-        }
+    for (int i = 0; i < num_words; ++i) {
+        diffs += __builtin_popcountll(sigs[i] ^ sigs1[i]);
+    }
+    return diffs;
+} 
+
+int Wire::sig_diffs(const std::vector<unsigned long long>& sigs1)
+{
+    assert(num_sig_spots() == int(sigs1.size()));
+    int num_words = num_sig_spots();
+    if (num_words == 0) {
+        return 0;
+    }
+    const unsigned long long* sigs = sig_matrix->row(sig_row);
+    int diffs = 0;
+    for (int i = 0; i < num_words; ++i) {
+        diffs += __builtin_popcountll(sigs[i] ^ sigs1[i]);
     }
     return diffs;
 } 
 
 bool Wire::sig_equiv(Wire& wire1, CoverType type)
 {
-    assert(signatures.size() == wire1.signatures.size());
+    assert(num_sig_spots() == wire1.num_sig_spots());
+    int num_words = num_sig_spots();
+    if (num_words == 0) {
+        return true;
+    }
+    const unsigned long long* sigs = sig_matrix->row(sig_row);
+    const unsigned long long* sigs1 = wire1.sig_matrix->row(wire1.sig_row);
 
-    for (int i = 0; i < int(signatures.size()); ++i) {
+    for (int i = 0; i < num_words; ++i) {
         if (type == EQUAL) {
-            if (signatures[i] != wire1.signatures[i]) {
+            if (sigs[i] != sigs1[i]) {
                 return false;
             }
         } else if (type == AND) {
             // signature covered by another signature
-            if (signatures[i] != (signatures[i] & wire1.signatures[i])) {
+            if (sigs[i] != (sigs[i] & sigs1[i])) {
                 return false;
             }
         } else if (type == OR) {
             // signature covered by another signature
-            if (signatures[i] != (signatures[i] | wire1.signatures[i])) {
+            if (sigs[i] != (sigs[i] | sigs1[i])) {
                 return false;
             }
         } else {
@@ -79,9 +99,9 @@ void Wire::randomize()
 
 bool Wire::is_output()
 {
-    for (unsigned int i = 0; i < outputs.size(); ++i) {
-        if (outputs[i]->get_inst()->get_is_port() ||
-            outputs[i]->get_inst()->get_is_latch()) {
+    for (unsigned int i = 0; i < outputs.size; ++i) {
+        Inst* inst = get_output(i)->get_inst();
+        if (inst->get_is_port() || inst->get_is_latch()) {
             return true;
         }
     }
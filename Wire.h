@@ -2,21 +2,29 @@
 #define WIRE_H
 
 #include "CircuitElement.h"
+#include "SignatureMatrix.h"
 #include <vector>
 
 #define SIGSTEP (sizeof(unsigned long long)*8)
 enum CoverType { NOCOVER, EQUAL, AND, OR };
 
+//! bit of a cover type in a set of covers
+inline unsigned int cover_bit(CoverType type)
+{
+    return 1u << type;
+}
+const unsigned int ALL_COVERS = (1u << EQUAL) | (1u << AND) | (1u << OR);
+
 class Port;
 
+/*!
+ * Wires are created by a Netlist, which also holds their fanout.
+*/
 class Wire : public CircuitElement {
   public:
-    Wire(std::string name_) : CircuitElement(name_), driver(0), sig_temp(0) {}
-
-    CircuitElementType get_type() const
-    {
-        return WIRE;
-    }
+    Wire(unsigned int name_id_, Netlist* netlist_, unsigned int id_) :
+        CircuitElement(name_id_, netlist_, WIRE, id_), driver(0), sig_temp(0),
+        sig_matrix(0), sig_row(-1), slot(0) {}
 
     Port* get_driver()
     {
@@ -30,12 +38,12 @@ class Wire : public CircuitElement {
 
     unsigned int num_outputs() const
     {
-        return outputs.size();
+        return outputs.size;
     }
 
     Port* get_output(int id)
     {
-        return outputs[id];
+        return netlist->fanouts.at(outputs, id);
     }
 
     /*!
@@ -44,15 +52,22 @@ class Wire : public CircuitElement {
     */
     void reassign_outputs(Wire* wire);
 
-    typedef std::vector<Port*>::iterator output_iterator;
+    //! invalidated when a fanout list grows
+    typedef Port** output_iterator;
 
     output_iterator output_begin()
     {
-       return output_iterator(outputs.begin()); 
+       return netlist->fanouts.begin(outputs);
     }
     output_iterator output_end()
     {
-       return output_iterator(outputs.end()); 
+       return netlist->fanouts.end(outputs);
+    }
+
+    //! fanout list in the netlist (for compaction)
+    ListRange& get_output_list()
+    {
+        return outputs;
     }
     
     unsigned long long get_sig_temp() const
@@ -65,45 +80,69 @@ class Wire : public CircuitElement {
         sig_temp = sig_temp_;
     }
     
-    int num_sig_spots()
+    //! slot of the wire in the compiled simulation program
+    unsigned int get_slot() const
+    {
+        return slot;
+    }
+
+    void set_slot(unsigned int slot_)
+    {
+        slot = slot_;
+    }
+
+    /*!
+     * Keep the signature in row sig_row_ of the matrix (a row of -1
+     * means that the signature of the wire is not retained).
+    */
+    void set_signature_row(SignatureMatrix* sig_matrix_, int sig_row_)
     {
-        return signatures.size();
+        sig_matrix = sig_matrix_;
+        sig_row = sig_row_;
     }
 
-    void commit_signature()
+    int get_signature_row() const
     {
-        signatures.push_back(sig_temp);
+        return sig_row;
     }
 
-    void clear_signature()
+    int num_sig_spots() const
     {
-        signatures.clear();
+        return (sig_row < 0) ? 0 : sig_matrix->get_num_words();
     }
 
     int sig_diffs(Wire& wire1);
+    int sig_diffs(const std::vector<unsigned long long>& sigs);
     bool sig_equiv(Wire& wire1, CoverType type = EQUAL); 
     
     void randomize();
 
-    unsigned long long get_signature(int i)
+    unsigned long long get_signature(int i) const
     {
-        return signatures[i];
+        return sig_matrix->row(sig_row)[i];
     }
     
-    std::vector<unsigned long long> get_signature()
+    std::vector<unsigned long long> get_signature() const
     {
-        return signatures;
+        if (sig_row < 0) {
+            return std::vector<unsigned long long>();
+        }
+        const unsigned long long* sigs = sig_matrix->row(sig_row);
+        return std::vector<unsigned long long>(sigs, sigs + num_sig_spots());
     }
 
   private:
-    std::vector<Port*> outputs;
+    ListRange outputs;
     Port* driver;
 
     //! contains value from simulation, not yet saved to signatures
     unsigned long long sig_temp;
     
-    std::vector<unsigned long long> signatures;
+    //! signature words (owned by the circuit)
+    SignatureMatrix* sig_matrix;
+    int sig_row;
 
+    unsigned int slot;
 };
 
 #endif
@@ -0,0 +1,16 @@
+import circuitlock_test_compare
+
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c880.blif --test-file ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c880.test --compute-testability 1 --write-aiger ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/c880.aig'
+
+outfile = "test_aiger.out" 
+file_comps = ["c880.aig"] 
+
+circuitlock_test_compare.compare_outputs(exe_string, outfile, file_comps)
+
+# read the AIGER file back; testability of the candidate gates must not change
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/c880.aig --test-file ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c880.test --compute-testability 1'
+
+outfile = "test_aigerread.out" 
+file_comps = [] 
+
+circuitlock_test_compare.compare_outputs(exe_string, outfile, file_comps)
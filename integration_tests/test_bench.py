@@ -0,0 +1,13 @@
+import circuitlock_test_compare
+
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c17.bench --test-file ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c17.test --compute-testability 1 --write-blif ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/c17.blif'
+
+outfile = "test_bench.out" 
+file_comps = ["c17.blif"] 
+
+circuitlock_test_compare.compare_outputs(exe_string, outfile, file_comps)
+
+# the hand-written BLIF of the same circuit must give identical results
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c17.blif --test-file ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c17.test --compute-testability 1 --write-blif ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/c17.blif'
+
+circuitlock_test_compare.compare_outputs(exe_string, outfile, file_comps)
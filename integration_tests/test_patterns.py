@@ -0,0 +1,15 @@
+import circuitlock_test_compare
+
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c880.blif --test-file ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c880.test --write-patterns ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/c880.pat --lock-randxor 8 --random-seed 3 --crack-key 1'
+
+outfile = "test_patterns.out" 
+file_comps = ["c880.pat"] 
+
+circuitlock_test_compare.compare_outputs(exe_string, outfile, file_comps)
+
+# the packed pattern file must drive the same locking and key search
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/inputs/c880.blif --test-file ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/c880.pat --lock-randxor 8 --random-seed 3 --crack-key 1'
+
+file_comps = [] 
+
+circuitlock_test_compare.compare_outputs(exe_string, outfile, file_comps)
@@ -0,0 +1,28 @@
+import os
+import shutil
+import circuitlock_test_compare
+
+inputs = circuitlock_test_compare.cmakepath + "/integration_tests/inputs/"
+temp_data = circuitlock_test_compare.testoutprefix
+
+if not os.path.exists(temp_data):
+    os.makedirs(temp_data)
+shutil.copy(inputs + "c880.blif", temp_data + "c880resp.blif")
+shutil.copy(inputs + "c880.test", temp_data + "c880resp.test")
+if os.path.exists(temp_data + "c880resp.resp"):
+    os.remove(temp_data + "c880resp.resp")
+
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/c880resp.blif --test-file ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/c880resp.test --lock-randxor 8 --random-seed 3 --crack-key 1 --cache-responses 1'
+
+# the first run writes the responses and the second reuses them
+circuitlock_test_compare.compare_outputs(exe_string, "test_respcache.out")
+circuitlock_test_compare.compare_outputs(exe_string, "test_respcachehit.out")
+
+# change one gate; the saved responses must not be reused
+blif = open(temp_data + "c880resp.blif").read()
+blif = blif.replace(".names 29 36 42 n88\n111 1\n", ".names 29 36 42 n88\n111 0\n")
+fout = open(temp_data + "c880resp.blif", 'w')
+fout.write(blif)
+fout.close()
+
+circuitlock_test_compare.compare_outputs(exe_string, "test_respcacheedit.out")
@@ -0,0 +1,15 @@
+import circuitlock_test_compare
+
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/inputs/alu4.blif --lock-randxor 16 --random-seed 5 --write-binary-netlist ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/alu4.snap --write-blif ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/alu4lock.blif'
+
+outfile = "test_snapshot.out" 
+file_comps = ["alu4lock.blif"] 
+
+circuitlock_test_compare.compare_outputs(exe_string, outfile, file_comps)
+
+# the binary netlist must reload to the same locked netlist and key values
+exe_string = '${BUILDLOC}/bin/CircuitLock ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/alu4.snap --write-blif ${CMAKE_SOURCE_DIR}/integration_tests/temp_data/alu4lock.blif'
+
+outfile = "test_snapshotread.out" 
+
+circuitlock_test_compare.compare_outputs(exe_string, outfile, file_comps)
@@ -3,6 +3,8 @@
 #include "OptionParser.h"
 #include "utils.h"
 #include "CrackKey.h"
+#include "ThreadPool.h"
+#include "NativeSim.h"
 #include <cstdlib>
 #include "Inst.h"
 
@@ -13,43 +15,88 @@ using std::vector;
 using std::tr1::unordered_set;
 using std::vector;
 
+// c3540.test -> c3540.resp
+string response_filename(string test_file)
+{
+    size_t dot = test_file.rfind('.');
+    size_t slash = test_file.rfind('/');
+    if ((dot != string::npos) && ((slash == string::npos) || (dot > slash))) {
+        test_file = test_file.substr(0, dot);
+    }
+    return test_file + ".resp";
+}
+
 int main(int argc, char** argv)
 {
     string blif_file;
     string output_file;
+    string binary_netlist_file;
+    string aiger_file;
     string test_file;
+    string pattern_file;
     int random_xors = 0;
+    int fault_impact_xors = 0;
     bool crack_key = false;
     int random_seed = 0;
     int random_mux = 0;
     int test_rounds = 0;
     bool mux_cands = false;
+    bool observable_xors = false;
     bool compute_testability = false;
+    int sim_word_width = 0;
+    int num_threads = 1;
+    string native_sim_dir;
+    bool cache_responses = false;
 
 
     try {
         OptionParser parser("Program for obfuscating and cracking a combinational circuit"); 
-        parser.add_positional(blif_file, "blif-file", "circuit in BLIF format");
+        parser.add_positional(blif_file, "blif-file", "circuit in BLIF, AIGER (.aig/.aag) or ISCAS (.bench) format, or a binary netlist");
         parser.add_option(output_file, "write-blif", "Write COMBINATIONAL circuit in BLIF format to specified file (will remove latches from sequential circuit)");
+        parser.add_option(aiger_file, "write-aiger", "Write COMBINATIONAL circuit in binary AIGER format to specified file (key inputs follow the primary inputs)");
+        parser.add_option(binary_netlist_file, "write-binary-netlist", "Write the (locked) circuit as a binary netlist that can be read instead of a BLIF file without parsing");
         parser.add_option(random_xors, "lock-randxor", "Number of random XORs to add");
+        parser.add_option(fault_impact_xors, "lock-fault-impact", "Number of XORs to add at the gates whose stuck-at faults disturb the most random patterns");
+        parser.add_option(observable_xors, "observable-xors", "Only add random XORs at gates observable at the outputs for the random simulation vectors");
         parser.add_option(random_mux, "lock-mux", "Number of random test-aware MUXs to add");
-        parser.add_option(test_file, "test-file", "File containing test vectors");
+        parser.add_option(test_file, "test-file", "File containing test vectors (text or packed pattern file)");
+        parser.add_option(pattern_file, "write-patterns", "Write the test vectors as a packed pattern file that can be read faster with --test-file");
         parser.add_option(crack_key, "crack-key", "Try to crack the key"); 
         parser.add_option(test_rounds, "num-test-rounds", "Number of rounds of testing on mux locked circuit"); 
         parser.add_option(random_seed, "random-seed", "Initial seed to use for execution");    
         parser.add_option(mux_cands, "mux-cands", "Show random MUX candidates", true, false, true); 
         parser.add_option(compute_testability, "compute-testability", "Compute testability of original circuit"); 
+        parser.add_option(cache_responses, "cache-responses", "Save unlocked circuit responses to the test vectors in a .resp file next to the test file (reused by later runs)"); 
+        parser.add_option(num_threads, "num-threads", "Number of threads used for simulation (0 uses all hardware threads)"); 
+        parser.add_option(sim_word_width, "sim-word-width", "Simulation word width in bits (64, 256, or 512; 0 uses the widest supported by the CPU)"); 
+        parser.add_option(native_sim_dir, "native-sim", "Compile circuits to native code for simulation, caching the shared objects in the given directory (uses the interpreter if no compiler is found)"); 
         parser.parse_options(argc, argv);
 
         srand(random_seed);
+        SimProgram::set_word_width(sim_word_width);
+        NativeSim::set_cache_dir(native_sim_dir);
+        ThreadPool::set_default_threads(num_threads);
 
         cout << "Read Circuit" << endl;
         TechLibrary library;
         EncryptedCircuit circuit(blif_file, &library);
         circuit.print_info();
+        if (circuit.get_num_keys() > 0) {
+            circuit.print_keys();
+        }
+
+        // a locked binary netlist does not hold the unlocked netlist
+        // that locking and cracking compare against
+        if ((circuit.get_num_keys() > 0) && ((random_xors > 0) || (fault_impact_xors > 0) ||
+                    (random_mux > 0) || crack_key)) {
+            throw Error("Cannot lock or crack a circuit that already has keys");
+        }
 
         if (test_file != "") {
             circuit.load_test_vectors(test_file);
+            if (pattern_file != "") {
+                circuit.write_test_vectors(pattern_file);
+            }
         }
 
         if (compute_testability) {
@@ -58,11 +105,18 @@ int main(int argc, char** argv)
 
         if (random_xors > 0) {
             cout << "Add XORs" << endl;
-            circuit.add_random_xors(random_xors);
+            circuit.add_random_xors(random_xors, observable_xors);
             circuit.print_keys();
             circuit.print_info();    
         }
 
+        if (fault_impact_xors > 0) {
+            cout << "Add fault impact XORs" << endl;
+            circuit.add_fault_impact_xors(fault_impact_xors);
+            circuit.print_keys();
+            circuit.print_info();
+        }
+
         if (random_mux > 0) {
             cout << "Add MUXs" << endl;
             circuit.add_test_mux(random_mux, mux_cands);
@@ -132,25 +186,13 @@ int main(int argc, char** argv)
         unordered_set<Inst*> stuck1;
         if ((test_rounds > 0) && (random_mux > 0)) {
             cout << "Compute fault percentage" << endl;
-            vector<Inst*> new_gates = circuit.get_new_gates();
-            for (int i = 0; i < new_gates.size(); ++i) {
-                new_gates[i]->set_visited(true);
-            }
-
             circuit.correctly_set_keys();
-            circuit.print_testability();            
+            circuit.print_testability(circuit.get_new_gates());
             
-            while (test_rounds-- > 0) { 
-                circuit.randomly_set_keys();
-                circuit.print_testability_prob(stuck0, stuck1);
-            }
-
-            for (int i = 0; i < new_gates.size(); ++i) {
-                new_gates[i]->set_visited(false);
-            }
+            circuit.print_testability_prob(test_rounds, stuck0, stuck1);
         }
 
-        if (crack_key && ((random_xors > 0) || (random_mux > 0))) {
+        if (crack_key && ((random_xors > 0) || (fault_impact_xors > 0) || (random_mux > 0))) {
             cout << "Crack the keys" << endl;
             bool use_test = true;
             int rand_sim = 0;
@@ -162,6 +204,9 @@ int main(int argc, char** argv)
             Circuit unlocked_circuit(blif_file, &library);
             unlocked_circuit.load_test_vectors(test_file);
             CrackKey crack(&unlocked_circuit, &circuit);
+            if (cache_responses && (test_file != "")) {
+                crack.set_response_file(response_filename(test_file));
+            }
             vector<bool> key_values;
             if (crack.generate_key(key_values, rand_sim, use_test)) {
                 bool equal = true;  
@@ -183,6 +228,12 @@ int main(int argc, char** argv)
         if (output_file != "") {
             circuit.write_blif(output_file);
         }
+        if (aiger_file != "") {
+            circuit.write_aiger(aiger_file);
+        }
+        if (binary_netlist_file != "") {
+            circuit.write_snapshot(binary_netlist_file);
+        }
     } catch (Error &msg) {
         cout << "Error: " << msg.msg << endl;
     }